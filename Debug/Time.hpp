@@ -15,12 +15,12 @@ struct Time {
     template<class Functor>
     Time(Functor func) {
         std::chrono::steady_clock::time_point t1, t2;
-        t1 = std::chrono::high_resolution_clock::now();
+        t1 = std::chrono::steady_clock::now();
         value = func();
-        t2 = std::chrono::high_resolution_clock::now();
+        t2 = std::chrono::steady_clock::now();
         std::chrono::duration<double, std::milli> msm = t2 - t1;
         asMilli = msm.count();
-        std::chrono::duration<double, std::centi> msc = t2 - t1;
+        std::chrono::duration<double> msc = t2 - t1;
         asSec = msc.count();
     }
 };
@@ -33,12 +33,12 @@ struct Time<void> {
     template<class Functor>
     Time(Functor func) {
         std::chrono::steady_clock::time_point t1, t2;
-        t1 = std::chrono::high_resolution_clock::now();
+        t1 = std::chrono::steady_clock::now();
         func();
-        t2 = std::chrono::high_resolution_clock::now();
+        t2 = std::chrono::steady_clock::now();
         std::chrono::duration<double, std::milli> msm = t2 - t1;
         asMilli = msm.count();
-        std::chrono::duration<double, std::centi> msc = t2 - t1;
+        std::chrono::duration<double> msc = t2 - t1;
         asSec = msc.count();
     }
 };
@@ -51,16 +51,16 @@ struct Clock {
 
     std::chrono::steady_clock::time_point time;
 
-    Clock(): time(std::chrono::high_resolution_clock::now()) {
+    Clock(): time(std::chrono::steady_clock::now()) {
 
     }
 
     Result End() {
         Result ret;
-        auto t2 = std::chrono::high_resolution_clock::now();
+        auto t2 = std::chrono::steady_clock::now();
         std::chrono::duration<double, std::milli> msm = t2 - time;
         ret.asMilli = msm.count();
-        std::chrono::duration<double, std::centi> msc = t2 - time;
+        std::chrono::duration<double> msc = t2 - time;
         ret.asSec = msc.count();
         return ret;
     }
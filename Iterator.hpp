@@ -22,6 +22,23 @@ struct const_random_access_iterator {
     using reference = T*&;  // or also value_type&
 };
 
+template<typename T>
+struct bidirectional_iterator {
+    using iterator_category = std::bidirectional_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = T;
+    using pointer = T*;  // or also value_type*
+    using reference = T&;  // or also value_type&
+};
+template<typename T>
+struct const_bidirectional_iterator {
+    using iterator_category = std::bidirectional_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = T*;
+    using pointer = T**;  // or also value_type*
+    using reference = T*&;  // or also value_type&
+};
+
 template<typename T>
 struct forward_iterator{
     using iterator_category = std::forward_iterator_tag;
@@ -55,6 +72,17 @@ struct const_input_iterator {
     using pointer = T**;  // or also value_type*
     using reference = T*&;  // or also value_type&
 };
+
+// For iterators whose reference is a prvalue ( a pair of references for example ), operator-> returns this
+// so that it->first works, it holds the reference and hands out its address
+template<typename _RefT>
+struct _Arrow_Proxy {
+    _RefT ref;
+
+    SSTD_INLINE _RefT* operator->() noexcept {
+        return &ref;
+    }
+};
 SSTD_END
 
 #endif
\ No newline at end of file
@@ -0,0 +1,220 @@
+#ifndef SSTD_ALLOCATOR_INCLUDED
+#define SSTD_ALLOCATOR_INCLUDED
+
+#include "core.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+SSTD_BEGIN
+
+// Where the containers get their memory from
+//
+// Unlike std allocators these hand out raw bytes, not objects of some type,
+// because the containers allocate a few different things ( control bytes, slots, nodes ... ) from the same one
+// An allocator needs
+//
+//   void* allocate(const sizet& bytes);                  // Throws std::bad_alloc if it can't
+//   void deallocate(void* ptr, const sizet& bytes);      // bytes is what was asked for
+//
+// and optionally
+//
+//   void* reallocate(void* ptr, const sizet& old_bytes, const sizet& new_bytes);
+//
+// which grows a block and keeps its bytes ( in place if it can ), see _Reallocate
+// An allocator made for small fixed size requests ( see pool_allocator ) can also have
+//
+//   sizet node_size() const;                              // Biggest request it serves itself
+//
+// then the node containers allocate every node that fits straight from it, instead of carving them out of slabs ( see _Node_Pool )
+// The memory has to be aligned like malloc's ( alignof(std::max_align_t) )
+//
+// A container holds a copy of its allocator, so stateful ones ( an arena, a NUMA node ... ) should be a cheap handle
+
+// The default, plain malloc / realloc / free
+struct malloc_allocator {
+	SSTD_INLINE void* allocate(const sizet& bytes) {
+		void* ptr = malloc(bytes);
+		if (ptr == nullptr && bytes != 0) {
+			throw std::bad_alloc();
+		}
+		return ptr;
+	}
+	SSTD_INLINE void deallocate(void* ptr, const sizet&) noexcept {
+		free(ptr);
+	}
+	// realloc can often extend the block in place, and moves the bytes for us otherwise
+	SSTD_INLINE void* reallocate(void* ptr, const sizet&, const sizet& new_bytes) {
+		void* res = realloc(ptr, new_bytes);
+		// ( The old block is still there if realloc fails )
+		if (res == nullptr && new_bytes != 0) {
+			throw std::bad_alloc();
+		}
+		return res;
+	}
+};
+
+// Whether _AllocT has a reallocate
+template<typename _AllocT, typename = void>
+struct _Has_Reallocate : std::false_type {};
+template<typename _AllocT>
+struct _Has_Reallocate<_AllocT, decltype(void(std::declval<_AllocT&>().reallocate(nullptr, sizet(), sizet())))> : std::true_type {};
+
+// Whether _AllocT has a node_size
+template<typename _AllocT, typename = void>
+struct _Has_Node_Size : std::false_type {};
+template<typename _AllocT>
+struct _Has_Node_Size<_AllocT, decltype(void(std::declval<const _AllocT&>().node_size()))> : std::true_type {};
+
+// Grow ( or shrink ) a block, keeping the first min(old_bytes, new_bytes) bytes
+// Only for memory holding trivially relocatable objects ( see relocate.hpp ), the bytes might move
+// Allocators without a reallocate get a new block and a memcpy
+template<typename _AllocT>
+SSTD_INLINE void* _Reallocate(_AllocT& alloc, void* ptr, const sizet& old_bytes, const sizet& new_bytes) {
+	if constexpr (_Has_Reallocate<_AllocT>::value) {
+		return alloc.reallocate(ptr, old_bytes, new_bytes);
+	}
+	else {
+		void* res = alloc.allocate(new_bytes);
+		if (ptr != nullptr) {
+			std::memcpy(res, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+			alloc.deallocate(ptr, old_bytes);
+		}
+		return res;
+	}
+}
+
+// -----------------------------------------
+//
+//   Block cache
+//
+// -----------------------------------------
+
+// Arenas and pools ( see arena.hpp and pool.hpp ) carve their memory out of blocks of _Block_Bytes
+SSTD_CONSTEXPR sizet _Block_Bytes = 64 * 1024;
+
+// Keeps the freed blocks around for the next arena / pool, instead of giving them back to malloc
+// So an arena that lives for a single request costs no malloc / free at all once the cache is warm
+//
+// Every thread keeps a few blocks for itself ( no locking ), and trades them with a shared list in batches
+// Bigger blocks than _Block_Bytes aren't cached, they go straight to malloc / free
+class _Block_Cache {
+public:
+	static SSTD_INLINE void* Get(const sizet& bytes) {
+		if (bytes > _Block_Bytes) {
+			return malloc_allocator().allocate(bytes);
+		}
+		_Local_List& local = _Local();
+		if (local.head == nullptr) {
+			_Take(local, local.closed ? 1 : _Batch);
+		}
+		if (local.head == nullptr) {
+			return malloc_allocator().allocate(_Block_Bytes);
+		}
+		return local.Pop();
+	}
+	static SSTD_INLINE void Put(void* block, const sizet& bytes) noexcept {
+		if (bytes > _Block_Bytes) {
+			free(block);
+			return;
+		}
+		_Local_List& local = _Local();
+		local.Push(static_cast<_Free_Block*>(block));
+		if (local.count > (local.closed ? 0 : _Local_Max)) {
+			_Give(local, local.closed ? local.count : _Batch);
+		}
+	}
+private:
+	// How many blocks a thread keeps, and how many move between it and the shared list at once
+	static SSTD_CONSTEXPR sizet _Local_Max = 16;
+	static SSTD_CONSTEXPR sizet _Batch = _Local_Max / 2;
+	// The shared list frees anything past this ( 16 MiB )
+	static SSTD_CONSTEXPR sizet _Shared_Max = 256;
+
+	struct _Free_Block {
+		_Free_Block* next;
+	};
+
+	struct _Block_List {
+		_Free_Block* head = nullptr;
+		sizet count = 0;
+
+		SSTD_INLINE void Push(_Free_Block* block) noexcept {
+			block->next = head;
+			head = block;
+			++count;
+		}
+		SSTD_INLINE _Free_Block* Pop() noexcept {
+			_Free_Block* block = head;
+			head = block->next;
+			--count;
+			return block;
+		}
+	};
+
+	struct _Shared_List : _Block_List {
+		std::mutex mutex;
+	};
+
+	// Trivially destructible, so it's still usable while the other thread locals get destructed
+	// ( _Local_Flush empties it at thread exit, and after that it's closed: every block goes through the shared list )
+	struct _Local_List : _Block_List {
+		bool closed = false;
+	};
+
+	struct _Local_Flush {
+		~_Local_Flush() {
+			_Local_List& local = _Local_Raw();
+			_Give(local, local.count);
+			local.closed = true;
+		}
+	};
+
+	// Move up to n blocks from the shared list to local
+	static SSTD_INLINE void _Take(_Local_List& local, sizet n) {
+		_Shared_List& shared = _Shared();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		for (; n && shared.head; --n) {
+			local.Push(shared.Pop());
+		}
+	}
+
+	// Move n blocks from local to the shared list ( or free them if that's full )
+	static SSTD_INLINE void _Give(_Local_List& local, sizet n) noexcept {
+		_Shared_List& shared = _Shared();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		for (; n && local.head; --n) {
+			_Free_Block* block = local.Pop();
+			if (shared.count < _Shared_Max) {
+				shared.Push(block);
+			}
+			else {
+				free(block);
+			}
+		}
+	}
+
+	// Never destructed, the thread lists of the last threads still flush into it at exit
+	static SSTD_INLINE _Shared_List& _Shared() {
+		static _Shared_List* shared = new _Shared_List();
+		return *shared;
+	}
+
+	static SSTD_INLINE _Local_List& _Local_Raw() noexcept {
+		thread_local _Local_List local;
+		return local;
+	}
+	static SSTD_INLINE _Local_List& _Local() noexcept {
+		thread_local _Local_Flush flush;
+		(void)flush;
+		return _Local_Raw();
+	}
+};
+
+SSTD_END
+
+#endif
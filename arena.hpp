@@ -0,0 +1,188 @@
+#ifndef SSTD_ARENA_INCLUDED
+#define SSTD_ARENA_INCLUDED
+
+#include "core.hpp"
+#include "allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+SSTD_BEGIN
+
+// A monotonic ( bump ) allocator, for memory that all dies at the same time ( everything a request allocates, for example )
+// Allocating just moves a pointer forward inside of the current block, and a new block is chained on when it runs out
+// Nothing is freed one by one, reset() throws everything away at once and keeps a block for the next round
+//
+// The blocks come from the block cache ( see _Block_Cache ), so even a new arena per request doesn't call malloc once it's warm
+// Not thread safe, use one arena per thread ( see thread_arena )
+//
+// The containers can allocate from it through arena_allocator
+// Destructing a container in an arena still runs the destructors of its elements,
+// but that's skipped for trivially destructible ones, and handing the memory back costs nothing
+class arena {
+public:
+	arena() SSTD_DEFAULT;
+	arena(const arena&) = delete;
+	arena& operator=(const arena&) = delete;
+
+	~arena() {
+		release();
+	}
+
+	// align has to be a power of 2
+	SSTD_INLINE void* allocate(const sizet& bytes, const sizet& align = alignof(std::max_align_t)) {
+		unsigned char* ptr = _Align(m_cur, align);
+		if (m_block == nullptr || ptr > m_end || bytes > static_cast<sizet>(m_end - ptr)) {
+			_New_Block(bytes + align);
+			ptr = _Align(m_cur, align);
+		}
+		m_last = ptr;
+		m_cur = ptr + bytes;
+		m_used += bytes;
+		return ptr;
+	}
+
+	// Only the last allocation is actually given back ( so a temporary buffer can be popped off again )
+	// Everything else stays until reset
+	SSTD_INLINE void deallocate(void* ptr, const sizet& bytes) noexcept {
+		if (ptr != nullptr && ptr == m_last && m_last + bytes == m_cur) {
+			m_cur = m_last;
+			m_used -= bytes;
+			m_last = nullptr;
+		}
+	}
+
+	// The last allocation grows in place if its block has room, so a vector growing at the top of the arena never copies
+	SSTD_INLINE void* reallocate(void* ptr, const sizet& old_bytes, const sizet& new_bytes) {
+		if (ptr != nullptr && ptr == m_last && m_last + old_bytes == m_cur && new_bytes <= static_cast<sizet>(m_end - m_last)) {
+			m_cur = m_last + new_bytes;
+			m_used = m_used - old_bytes + new_bytes;
+			return ptr;
+		}
+		void* res = allocate(new_bytes);
+		if (ptr != nullptr) {
+			std::memcpy(res, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+		}
+		return res;
+	}
+
+	// Throw away everything allocated so far, but keep the current block around for what comes next
+	SSTD_INLINE void reset() noexcept {
+		if (m_block == nullptr) {
+			return;
+		}
+		_Release_Blocks(m_block->prev);
+		m_block->prev = nullptr;
+		if (m_block->bytes > _Block_Bytes) {
+			// Don't hold on to a huge block
+			release();
+			return;
+		}
+		m_cur = reinterpret_cast<unsigned char*>(m_block + 1);
+		m_last = nullptr;
+		m_used = 0;
+	}
+
+	// Give every block back
+	SSTD_INLINE void release() noexcept {
+		_Release_Blocks(m_block);
+		m_block = nullptr;
+		m_cur = nullptr;
+		m_end = nullptr;
+		m_last = nullptr;
+		m_used = 0;
+	}
+
+	// Bytes handed out since the last reset
+	SSTD_INLINE sizet used() const noexcept {
+		return m_used;
+	}
+private:
+	// At the start of every block
+	struct alignas(std::max_align_t) _Block {
+		_Block* prev;
+		sizet bytes;
+	};
+
+	_Block* m_block = nullptr;
+	unsigned char* m_cur = nullptr;
+	unsigned char* m_end = nullptr;
+	// Where the last allocation starts ( for deallocate / reallocate )
+	unsigned char* m_last = nullptr;
+	sizet m_used = 0;
+
+	static SSTD_INLINE unsigned char* _Align(unsigned char* ptr, const sizet& align) noexcept {
+		return reinterpret_cast<unsigned char*>(_Align_Address(reinterpret_cast<std::uintptr_t>(ptr), align));
+	}
+	static SSTD_INLINE SSTD_CONSTEXPR std::uintptr_t _Align_Address(const std::uintptr_t& address, const sizet& align) noexcept {
+		return (address + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+	}
+
+	// A block with room for at least bytes ( a standard one, unless bytes doesn't fit in there )
+	SSTD_INLINE void _New_Block(const sizet& bytes) {
+		const sizet block_bytes = bytes + sizeof(_Block) > _Block_Bytes ? bytes + sizeof(_Block) : _Block_Bytes;
+		_Block* block = static_cast<_Block*>(_Block_Cache::Get(block_bytes));
+		block->prev = m_block;
+		block->bytes = block_bytes;
+		m_block = block;
+		m_cur = reinterpret_cast<unsigned char*>(block + 1);
+		m_end = reinterpret_cast<unsigned char*>(block) + block_bytes;
+		m_last = nullptr;
+	}
+
+	static SSTD_INLINE void _Release_Blocks(_Block* block) noexcept {
+		while (block) {
+			_Block* prev = block->prev;
+			_Block_Cache::Put(block, block->bytes);
+			block = prev;
+		}
+	}
+};
+
+// Lets the containers allocate from an arena ( see allocator.hpp )
+// Just a pointer, so the arena has to outlive every container using it
+class arena_allocator {
+public:
+	arena_allocator(arena& _arena) noexcept :
+		m_arena(&_arena) {
+
+	}
+
+	SSTD_INLINE void* allocate(const sizet& bytes) {
+		return m_arena->allocate(bytes);
+	}
+	SSTD_INLINE void deallocate(void* ptr, const sizet& bytes) noexcept {
+		m_arena->deallocate(ptr, bytes);
+	}
+	SSTD_INLINE void* reallocate(void* ptr, const sizet& old_bytes, const sizet& new_bytes) {
+		return m_arena->reallocate(ptr, old_bytes, new_bytes);
+	}
+private:
+	arena* m_arena;
+};
+
+// The arena of the calling thread
+// Reset it once the work that used it is done ( at the end of a request )
+SSTD_INLINE arena& thread_arena() noexcept {
+	thread_local arena local;
+	return local;
+}
+
+// Allocates from the arena of whichever thread is calling ( so it's an empty type, and default constructible )
+// The memory is only valid on that thread until its next reset, so keep the containers using it on that thread too
+struct thread_arena_allocator {
+	SSTD_INLINE void* allocate(const sizet& bytes) {
+		return thread_arena().allocate(bytes);
+	}
+	SSTD_INLINE void deallocate(void* ptr, const sizet& bytes) noexcept {
+		thread_arena().deallocate(ptr, bytes);
+	}
+	SSTD_INLINE void* reallocate(void* ptr, const sizet& old_bytes, const sizet& new_bytes) {
+		return thread_arena().reallocate(ptr, old_bytes, new_bytes);
+	}
+};
+
+SSTD_END
+
+#endif
@@ -0,0 +1,103 @@
+// Throughput of a concurrent_unordered_map from 1 to 64 threads, for a read heavy and a write heavy mix
+//
+//   g++ -std=c++17 -O2 -march=native -pthread -I.. concurrent_unordered_map_scaling.cpp -o concurrent_unordered_map_scaling && ./concurrent_unordered_map_scaling [elements] [ops]
+//
+// The map starts with elements keys out of a key range twice as big, so about half the finds and erases hit
+// Every thread runs ops / threads operations on random keys of that range:
+//   read heavy:  95% find, 5% insert / erase / upsert
+//   write heavy: 50% find, 50% insert / erase / upsert
+// More threads than cores only measures how well the locks hold up when threads get descheduled while holding one,
+// so look at the rows up to the core count for the scaling
+
+#include "concurrent_unordered_map.hpp"
+#include "Debug/Time.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using key_type = sstd::uint64;
+using map_type = sstd::concurrent_unordered_map<key_type, key_type>;
+
+// Small and fast enough not to show up next to the map
+struct _Rng {
+	sstd::uint64 state;
+
+	sstd::uint64 operator()() noexcept {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+};
+
+// writes is out of 100
+static void _Worker(map_type& map, const sstd::sizet& range, const sstd::sizet& ops, const unsigned& writes, const unsigned& id,
+	const std::atomic<bool>& go, sstd::uint64& sink) {
+	_Rng rng{ 0x9E3779B97F4A7C15ull * (id + 1) };
+	sstd::uint64 found = 0;
+	key_type out;
+	while (!go.load(std::memory_order_acquire)) {
+		std::this_thread::yield();
+	}
+	for (sstd::sizet i = 0; i < ops; ++i) {
+		const sstd::uint64 r = rng();
+		const key_type key = (r >> 8) % range;
+		const unsigned roll = static_cast<unsigned>(r & 0xff) % 100;
+		if (roll >= writes) {
+			found += map.find(key, out);
+		}
+		else if (roll % 3 == 0) {
+			map.insert(key, key);
+		}
+		else if (roll % 3 == 1) {
+			found += map.erase(key);
+		}
+		else {
+			map.upsert(key, [](key_type& elt) { ++elt; }, key);
+		}
+	}
+	sink = found;
+}
+
+static sstd::Decimal _Run(const sstd::sizet& elements, const sstd::sizet& ops, const unsigned& threads, const unsigned& writes) {
+	// Best of a few rounds, the scheduler makes these noisy
+	sstd::Decimal best = 1e18;
+	for (int round = 0; round < 3; ++round) {
+		map_type map(elements * 2);
+		for (key_type i = 0; i < elements * 2; i += 2) {
+			map.insert(i, i);
+		}
+		std::atomic<bool> go(false);
+		std::vector<sstd::uint64> sinks(threads);
+		std::vector<std::thread> pool;
+		pool.reserve(threads);
+		for (unsigned t = 0; t < threads; ++t) {
+			pool.emplace_back(_Worker, std::ref(map), elements * 2, ops / threads, writes, t, std::cref(go), std::ref(sinks[t]));
+		}
+		sstd::Clock clock;
+		go.store(true, std::memory_order_release);
+		for (std::thread& thread : pool) {
+			thread.join();
+		}
+		best = std::min(best, clock.End().asMilli);
+	}
+	return ops / threads * threads / (best * 1e3);
+}
+
+int main(int argc, char** argv) {
+	const sstd::sizet elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000 * 1000;
+	const sstd::sizet ops = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 8 * 1000 * 1000;
+	std::printf("%zu elements, %zu ops, %u hardware threads\n", elements, ops, std::thread::hardware_concurrency());
+	std::printf("  threads   read heavy Mops/s   write heavy Mops/s\n");
+
+	for (unsigned threads = 1; threads <= 64; threads *= 2) {
+		const sstd::Decimal reads = _Run(elements, ops, threads, 5);
+		const sstd::Decimal writes = _Run(elements, ops, threads, 50);
+		std::printf("  %7u   %17.2f   %18.2f\n", threads, reads, writes);
+	}
+	return 0;
+}
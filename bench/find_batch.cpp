@@ -0,0 +1,93 @@
+// find_batch against a plain loop of find, on a table way bigger than the last level cache
+//
+//   g++ -std=c++17 -O2 -march=native -I.. find_batch.cpp -o find_batch && ./find_batch [elements]
+//
+// The default 32M elements take about 1.6 GB with the default probing, and 800 MB in groups
+// Every table is run on the normal 4 KiB pages and on 2 MiB pages ( see huge_page.hpp ),
+// with 4 KiB pages every lookup pays a page walk on top of its cache misses, and that limits how far the prefetching gets
+
+#include "unordered_map.hpp"
+#include "huge_page.hpp"
+#include "Debug/Time.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using key_type = sstd::uint64;
+using hash_type = sstd::hash<key_type>;
+
+template<typename _ProbT>
+using bench_map = sstd::unordered_map<key_type, key_type, hash_type, _ProbT, sstd::_Inline_Storage<key_type, key_type>, sstd::huge_page_allocator>;
+
+// Keys are spread out by a multiplication, and an eighth of the lookups miss
+static key_type _Key(const key_type& i) {
+	return i * 0x9E3779B97F4A7C15ull;
+}
+
+template<typename _ProbT>
+static void _Run(const char* name, const sstd::huge_pages& pages, const sstd::sizet& elements, const std::vector<key_type>& keys) {
+	bench_map<_ProbT> map{ sstd::huge_page_allocator(pages) };
+	map.reserve(elements);
+	for (key_type i = 0; i < elements; ++i) {
+		map[_Key(i)] = i;
+	}
+
+	// Best of a few rounds, the timings of a big table are noisy
+	const int rounds = 3;
+	sstd::Decimal loop_milli = 1e18;
+	sstd::Decimal batch_milli = 1e18;
+	// In chunks, like a join operator would
+	const sstd::sizet chunk = 1024;
+	std::vector<key_type*> out(chunk);
+	for (int round = 0; round < rounds; ++round) {
+		key_type sum = 0;
+		sstd::Clock loop_clock;
+		for (const key_type& key : keys) {
+			const auto it = map.find(key);
+			if (it != map.end()) {
+				sum += it.value();
+			}
+		}
+		loop_milli = std::min(loop_milli, loop_clock.End().asMilli);
+
+		key_type batch_sum = 0;
+		sstd::Clock batch_clock;
+		for (sstd::sizet start = 0; start < keys.size(); start += chunk) {
+			const sstd::sizet count = std::min(chunk, keys.size() - start);
+			map.find_batch(keys.data() + start, count, out.data());
+			for (sstd::sizet i = 0; i < count; ++i) {
+				if (out[i]) {
+					batch_sum += *out[i];
+				}
+			}
+		}
+		batch_milli = std::min(batch_milli, batch_clock.End().asMilli);
+
+		if (sum != batch_sum) {
+			std::printf("%s: find_batch found something else than find\n", name);
+			std::exit(1);
+		}
+	}
+	std::printf("%-8s %-6s find %6.1f ns/lookup   find_batch %6.1f ns/lookup   %.2fx\n", name, pages == sstd::huge_pages::none ? "4 KiB" : "2 MiB",
+		loop_milli * 1e6 / keys.size(), batch_milli * 1e6 / keys.size(), loop_milli / batch_milli);
+}
+
+int main(int argc, char** argv) {
+	const sstd::sizet elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 32 * 1024 * 1024;
+	std::printf("%zu elements\n", elements);
+
+	std::vector<key_type> keys(8 * 1024 * 1024);
+	std::mt19937_64 rng(42);
+	for (key_type& key : keys) {
+		key = _Key(rng() % (elements + elements / 8));
+	}
+
+	for (const sstd::huge_pages pages : { sstd::huge_pages::none, sstd::huge_pages::transparent }) {
+		_Run<sstd::_Double_Hash_Prob<key_type, hash_type> >("default", pages, elements, keys);
+		_Run<sstd::_Group_Prob<key_type, hash_type> >("group", pages, elements, keys);
+	}
+	return 0;
+}
@@ -0,0 +1,85 @@
+// Throughput of sstd::hash_bytes at different key lengths, and of the integer hash
+//
+//   g++ -std=c++17 -O2 -march=native -I.. hash.cpp -o hash && ./hash [total MiB per length]
+//
+// Short keys are about latency per call ( a table hashes one key per lookup ), so those print ns/hash too
+// Inputs from _Long_Hash_Bytes on go through the accumulator, which uses AVX2 / SSE2 when the build enables them,
+// build once with and once without -march=native to compare the paths
+
+#include "hash.hpp"
+#include "Debug/Time.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Keeps the compiler from dropping the hashes
+static volatile sstd::uint64 _Sink;
+
+static void _Bytes(const std::vector<sstd::uint8>& buf, const sstd::sizet& len, const sstd::sizet& total) {
+	// Walk through the buffer, so short keys don't all come from the same address
+	const sstd::sizet calls = std::max<sstd::sizet>(total / (len ? len : 1), 1);
+	const sstd::sizet span = buf.size() - len;
+	sstd::Decimal best = 1e18;
+	for (int round = 0; round < 3; ++round) {
+		sstd::uint64 acc = 0;
+		sstd::sizet offset = 0;
+		sstd::Clock clock;
+		for (sstd::sizet i = 0; i < calls; ++i) {
+			// Chain the seed through the hashes, so the calls can't overlap completely ( like a real lookup can't )
+			acc = sstd::hash_bytes(buf.data() + offset, len, acc);
+			offset += 64;
+			if (offset > span) {
+				offset = 0;
+			}
+		}
+		best = std::min(best, clock.End().asMilli);
+		_Sink = acc;
+	}
+	const sstd::Decimal ns = best * 1e6 / calls;
+	const sstd::Decimal gib = len * calls / (best / 1e3) / (1024.0 * 1024.0 * 1024.0);
+	std::printf("  %7zu bytes   %8.2f ns/hash   %7.2f GiB/s\n", len, ns, gib);
+}
+
+static void _Integers(const sstd::sizet& calls) {
+	sstd::Decimal best = 1e18;
+	for (int round = 0; round < 3; ++round) {
+		sstd::uint64 acc = 0;
+		sstd::Clock clock;
+		for (sstd::uint64 i = 0; i < calls; ++i) {
+			acc += sstd::hash<sstd::uint64>()(i, acc);
+		}
+		best = std::min(best, clock.End().asMilli);
+		_Sink = acc;
+	}
+	std::printf("  uint64          %8.2f ns/hash\n", best * 1e6 / calls);
+}
+
+int main(int argc, char** argv) {
+	const sstd::sizet total = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256) * 1024 * 1024;
+#if defined(SSTD_HAS_AVX2)
+	std::printf("accumulator: AVX2\n");
+#elif defined(SSTD_HAS_SSE2)
+	std::printf("accumulator: SSE2\n");
+#else
+	std::printf("accumulator: scalar\n");
+#endif
+
+	// Big enough for the longest key plus some room to move around, small enough to stay in the cache
+	std::vector<sstd::uint8> buf(256 * 1024);
+	std::mt19937_64 rng(42);
+	for (sstd::uint8& b : buf) {
+		b = static_cast<sstd::uint8>(rng());
+	}
+
+	const sstd::sizet lengths[] = { 4, 8, 16, 24, 32, 48, 64, 100, 256, sstd::_Long_Hash_Bytes - 1,
+		sstd::_Long_Hash_Bytes, 1024, 4096, 16384, 65536 };
+	for (const sstd::sizet& len : lengths) {
+		// Short keys get fewer calls, otherwise they'd take forever
+		_Bytes(buf, len, len < 64 ? total / 16 : total);
+	}
+	_Integers(total / 16);
+	return 0;
+}
@@ -0,0 +1,110 @@
+// Random reads on big containers, with 4 KiB pages against 2 MiB pages ( see huge_page.hpp )
+//
+//   g++ -std=c++17 -O2 -march=native -I.. huge_page.cpp -o huge_page && ./huge_page [elements]
+//
+// Two workloads, each once with huge_pages::none and once with huge_pages::transparent:
+//   gather: sum a vector<uint64> at random indices ( 8 bytes per element, so 128M elements are 1 GiB )
+//   find:   look up random keys in an unordered_map with elements / 4 keys
+// Next to the timings it prints how much of the process is backed by huge pages ( AnonHugePages of /proc/self/smaps_rollup ),
+// if that stays 0 with transparent, the kernel has them off ( /sys/kernel/mm/transparent_hugepage/enabled ) or ran out
+
+#include "huge_page.hpp"
+#include "unordered_map.hpp"
+#include "vector.hpp"
+#include "Debug/Time.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using key_type = sstd::uint64;
+using hash_type = sstd::hash<key_type>;
+using vector_type = sstd::vector<sstd::uint64, 0, sstd::huge_page_allocator>;
+using map_type = sstd::unordered_map<key_type, key_type, hash_type, sstd::_Group_Prob<key_type, hash_type>,
+	sstd::_Inline_Storage<key_type, key_type>, sstd::huge_page_allocator>;
+
+// KiB of the process backed by huge pages, -1 if the kernel doesn't say
+static long _Anon_Huge_Kib() {
+	std::FILE* file = std::fopen("/proc/self/smaps_rollup", "r");
+	if (file == nullptr) {
+		return -1;
+	}
+	long res = -1;
+	char line[256];
+	while (std::fgets(line, sizeof(line), file)) {
+		if (std::strncmp(line, "AnonHugePages:", 14) == 0) {
+			res = std::strtol(line + 14, nullptr, 10);
+			break;
+		}
+	}
+	std::fclose(file);
+	return res;
+}
+
+// Best of a few rounds, in ns per read
+template<typename _Fn>
+static sstd::Decimal _Time(const sstd::sizet& reads, _Fn&& fn) {
+	sstd::Decimal best = 1e18;
+	for (int round = 0; round < 3; ++round) {
+		sstd::Clock clock;
+		fn();
+		best = std::min(best, clock.End().asMilli);
+	}
+	return best * 1e6 / reads;
+}
+
+static void _Run(const char* name, const sstd::huge_pages& pages, const sstd::sizet& elements, const std::vector<sstd::uint64>& indices) {
+	const sstd::huge_page_allocator alloc(pages);
+	sstd::uint64 sum = 0;
+	sstd::Decimal gather_ns;
+	sstd::Decimal find_ns;
+	long gather_kib;
+	long find_kib;
+	{
+		vector_type v{ alloc };
+		v.resize(elements);
+		for (sstd::sizet i = 0; i < elements; ++i) {
+			v[i] = i;
+		}
+		gather_kib = _Anon_Huge_Kib();
+		gather_ns = _Time(indices.size(), [&]() {
+			for (const sstd::uint64& ind : indices) {
+				sum += v[ind % elements];
+			}
+		});
+	}
+	{
+		const sstd::sizet keys = elements / 4;
+		map_type map{ alloc };
+		map.reserve(keys);
+		for (key_type i = 0; i < keys; ++i) {
+			map[i] = i;
+		}
+		find_kib = _Anon_Huge_Kib();
+		find_ns = _Time(indices.size(), [&]() {
+			for (const sstd::uint64& ind : indices) {
+				sum += map.find(ind % keys) != map.end();
+			}
+		});
+	}
+	std::printf("%-12s gather %6.1f ns ( %7ld KiB huge )   find %6.1f ns ( %7ld KiB huge )   %llu\n", name, gather_ns, gather_kib,
+		find_ns, find_kib, static_cast<unsigned long long>(sum % 10));
+}
+
+int main(int argc, char** argv) {
+	const sstd::sizet elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 128 * 1024 * 1024;
+	std::printf("%zu elements\n", elements);
+
+	std::vector<sstd::uint64> indices(8 * 1024 * 1024);
+	std::mt19937_64 rng(42);
+	for (sstd::uint64& ind : indices) {
+		ind = rng();
+	}
+
+	_Run("4 KiB", sstd::huge_pages::none, elements, indices);
+	_Run("2 MiB", sstd::huge_pages::transparent, elements, indices);
+	return 0;
+}
@@ -0,0 +1,70 @@
+// Erase / insert churn on a table that stays the same size, like a cache that keeps replacing its entries
+// Prints how the probe lengths and tombstones develop over time, for the probing policies that leave tombstones and for robin hood
+//
+//   g++ -std=c++17 -O2 -march=native -I.. unordered_map_churn.cpp -o unordered_map_churn && ./unordered_map_churn [elements] [rounds]
+//
+// Every round erases elements random live keys and inserts as many new ones
+
+// The compaction / rehash counters of stats() are only tracked with this
+#define SSTD_HASH_TABLE_STATS
+
+#include "unordered_map.hpp"
+#include "Debug/Time.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using key_type = sstd::uint64;
+using hash_type = sstd::hash<key_type>;
+
+template<typename _Map>
+static void _Run(const char* name, const sstd::sizet& elements, const sstd::sizet& rounds) {
+	std::printf("%s\n", name);
+	std::printf("  round   ns/op   avg probe   max probe   tombstones   load   rehashes   compactions\n");
+
+	_Map map;
+	std::vector<key_type> live;
+	live.reserve(elements);
+	key_type next = 0;
+	for (; next < elements; ++next) {
+		map[next] = next;
+		live.push_back(next);
+	}
+
+	std::mt19937_64 rng(42);
+	for (sstd::sizet round = 0; round <= rounds; ++round) {
+		sstd::Decimal ns = 0;
+		if (round) {
+			sstd::Clock clock;
+			for (sstd::sizet i = 0; i < elements; ++i) {
+				// Erase a random live key, and replace it with a brand new one
+				const sstd::sizet victim = rng() % live.size();
+				map.erase(live[victim]);
+				map[next] = next;
+				live[victim] = next++;
+			}
+			ns = clock.End().asMilli * 1e6 / (2 * elements);
+		}
+		const sstd::hash_table_stats info = map.stats();
+		std::printf("  %5zu  %6.1f   %9.3f   %9zu   %10zu   %.2f   %8zu   %11zu\n", round, ns, info.average_probe_length, info.max_probe_length,
+			info.tombstones, info.load_factor, info.rehashes, info.compactions);
+		if (info.size != elements) {
+			std::printf("%s: lost track of the elements\n", name);
+			std::exit(1);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	const sstd::sizet elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000 * 1000;
+	const sstd::sizet rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10;
+	std::printf("%zu elements, %zu rounds\n", elements, rounds);
+
+	_Run<sstd::unordered_map<key_type, key_type, hash_type, sstd::_Group_Prob<key_type, hash_type> > >("group", elements, rounds);
+	_Run<sstd::unordered_map<key_type, key_type, hash_type, sstd::_Double_Hash_Prob<key_type, hash_type> > >("double hash", elements, rounds);
+	_Run<sstd::unordered_map<key_type, key_type, hash_type, sstd::_Linear_Prob<key_type, hash_type> > >("linear", elements, rounds);
+	_Run<sstd::unordered_map<key_type, key_type, hash_type, sstd::_Robin_Hood_Prob<key_type, hash_type> > >("robin hood", elements, rounds);
+	return 0;
+}
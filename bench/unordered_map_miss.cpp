@@ -0,0 +1,87 @@
+// Miss heavy lookups on a big table, for every probing policy ( and std::unordered_map to compare against )
+//
+//   g++ -std=c++17 -O2 -march=native -I.. unordered_map_miss.cpp -o unordered_map_miss && ./unordered_map_miss [elements]
+//
+// A lookup probes the control bytes only, and compares a key just when the hash fragment of its slot matches,
+// so a miss should hardly ever touch the ( big ) slots
+// Robin hood is the exception, it reads the cached hash of every slot it passes to know when to stop,
+// so it shows what touching the slots on every probing step costs
+// The elements are 48 bytes, like a small session record
+
+#include "unordered_map.hpp"
+#include "Debug/Time.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using key_type = sstd::uint64;
+using hash_type = sstd::hash<key_type>;
+
+struct session {
+	sstd::uint64 data[6];
+};
+
+// Inserted keys are even, so every odd key is a miss
+static key_type _Key(const key_type& i) {
+	return (i * 0x9E3779B97F4A7C15ull) << 1;
+}
+
+template<typename _Map>
+static sstd::Decimal _Lookup(const _Map& map, const std::vector<key_type>& keys, sstd::uint64& found) {
+	// Best of a few rounds, the timings of a big table are noisy
+	sstd::Decimal best = 1e18;
+	for (int round = 0; round < 3; ++round) {
+		found = 0;
+		sstd::Clock clock;
+		for (const key_type& key : keys) {
+			found += map.find(key) != map.end();
+		}
+		best = std::min(best, clock.End().asMilli);
+	}
+	return best * 1e6 / keys.size();
+}
+
+template<typename _Map>
+static void _Run(const char* name, const sstd::sizet& elements, const std::vector<key_type>& misses, const std::vector<key_type>& mixed) {
+	_Map map;
+	map.reserve(elements);
+	for (key_type i = 0; i < elements; ++i) {
+		map[_Key(i)] = session{ { i, 0, 0, 0, 0, 0 } };
+	}
+	sstd::uint64 found_misses;
+	sstd::uint64 found_mixed;
+	const sstd::Decimal miss_ns = _Lookup(map, misses, found_misses);
+	const sstd::Decimal mixed_ns = _Lookup(map, mixed, found_mixed);
+	if (found_misses != 0) {
+		std::printf("%s: found a key that was never inserted\n", name);
+		std::exit(1);
+	}
+	std::printf("%-22s all misses %6.1f ns/lookup   90%% misses %6.1f ns/lookup   ( %llu hits )\n", name, miss_ns, mixed_ns,
+		static_cast<unsigned long long>(found_mixed));
+}
+
+int main(int argc, char** argv) {
+	const sstd::sizet elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10 * 1000 * 1000;
+	std::printf("%zu elements\n", elements);
+
+	const sstd::sizet lookups = 4 * 1024 * 1024;
+	std::vector<key_type> misses(lookups);
+	std::vector<key_type> mixed(lookups);
+	std::mt19937_64 rng(42);
+	for (sstd::sizet i = 0; i < lookups; ++i) {
+		misses[i] = rng() | 1;
+		const key_type hit = _Key(rng() % elements);
+		mixed[i] = rng() % 10 == 0 ? hit : (rng() | 1);
+	}
+
+	_Run<sstd::unordered_map<key_type, session, hash_type, sstd::_Group_Prob<key_type, hash_type> > >("group", elements, misses, mixed);
+	_Run<sstd::unordered_map<key_type, session, hash_type, sstd::_Double_Hash_Prob<key_type, hash_type> > >("double hash", elements, misses, mixed);
+	_Run<sstd::unordered_map<key_type, session, hash_type, sstd::_Linear_Prob<key_type, hash_type> > >("linear", elements, misses, mixed);
+	_Run<sstd::unordered_map<key_type, session, hash_type, sstd::_Robin_Hood_Prob<key_type, hash_type> > >("robin hood", elements, misses, mixed);
+	_Run<std::unordered_map<key_type, session, hash_type> >("std::unordered_map", elements, misses, mixed);
+	return 0;
+}
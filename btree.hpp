@@ -0,0 +1,693 @@
+#ifndef SSTD_BTREE_INCLUDED
+#define SSTD_BTREE_INCLUDED
+
+#include "core.hpp"
+#include "relocate.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+SSTD_BEGIN
+
+// -----------------------------------------
+//
+//   Node search
+//
+// -----------------------------------------
+
+// Integer keys ordered by std::less get searched by counting instead of bisecting
+template<typename _KeyT, typename _Compare>
+struct _Is_Counted_Search : std::integral_constant<bool,
+	std::is_same<_Compare, std::less<_KeyT> >::value && std::is_integral<_KeyT>::value && !std::is_same<_KeyT, bool>::value> {};
+
+// How many of the count ( sorted ) keys are < key, or > key if _Greater
+// A node is only a few cache lines, so comparing key against all of them at once ( and counting the hits )
+// beats the unpredictable branches of a binary search
+// The SIMD compares are signed only, so unsigned keys get their top bit flipped first
+template<bool _Greater, typename _KeyT>
+SSTD_INLINE sizet _Count_Keys(const _KeyT* keys, const sizet& count, const _KeyT& key) noexcept {
+	sizet res = 0;
+	sizet i = 0;
+#if defined(SSTD_HAS_AVX2)
+	if constexpr (sizeof(_KeyT) == 4) {
+		const int32 flip = std::is_signed<_KeyT>::value ? 0 : std::numeric_limits<int32>::min();
+		const __m256i f = _mm256_set1_epi32(flip);
+		const __m256i k = _mm256_set1_epi32(static_cast<int32>(key) ^ flip);
+		for (; i + 8 <= count; i += 8) {
+			const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), f);
+			const __m256i hit = _Greater ? _mm256_cmpgt_epi32(v, k) : _mm256_cmpgt_epi32(k, v);
+			res += _Pop_Count(static_cast<uint32>(_mm256_movemask_ps(_mm256_castsi256_ps(hit))));
+		}
+	}
+	else if constexpr (sizeof(_KeyT) == 8) {
+		const int64 flip = std::is_signed<_KeyT>::value ? 0 : std::numeric_limits<int64>::min();
+		const __m256i f = _mm256_set1_epi64x(flip);
+		const __m256i k = _mm256_set1_epi64x(static_cast<int64>(key) ^ flip);
+		for (; i + 4 <= count; i += 4) {
+			const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), f);
+			const __m256i hit = _Greater ? _mm256_cmpgt_epi64(v, k) : _mm256_cmpgt_epi64(k, v);
+			res += _Pop_Count(static_cast<uint32>(_mm256_movemask_pd(_mm256_castsi256_pd(hit))));
+		}
+	}
+#elif defined(SSTD_HAS_SSE2)
+	// ( SSE2 has no 64 bit compare, those keys take the scalar loop below )
+	if constexpr (sizeof(_KeyT) == 4) {
+		const int32 flip = std::is_signed<_KeyT>::value ? 0 : std::numeric_limits<int32>::min();
+		const __m128i f = _mm_set1_epi32(flip);
+		const __m128i k = _mm_set1_epi32(static_cast<int32>(key) ^ flip);
+		for (; i + 4 <= count; i += 4) {
+			const __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), f);
+			const __m128i hit = _Greater ? _mm_cmpgt_epi32(v, k) : _mm_cmpgt_epi32(k, v);
+			res += _Pop_Count(static_cast<uint32>(_mm_movemask_ps(_mm_castsi128_ps(hit))));
+		}
+	}
+#endif
+	// Branchless, so the compiler is free to vectorize it too
+	for (; i < count; ++i) {
+		res += _Greater ? static_cast<sizet>(key < keys[i]) : static_cast<sizet>(keys[i] < key);
+	}
+	return res;
+}
+
+// Index of the first key >= key
+template<typename _KeyT, typename _Compare>
+SSTD_INLINE sizet _Node_Lower_Bound(const _KeyT* keys, const sizet& count, const _KeyT& key, const _Compare& comp) {
+	if constexpr (_Is_Counted_Search<_KeyT, _Compare>::value) {
+		return _Count_Keys<false>(keys, count, key);
+	}
+	else {
+		sizet lo = 0, hi = count;
+		while (lo < hi) {
+			const sizet mid = (lo + hi) / 2;
+			if (comp(keys[mid], key)) {
+				lo = mid + 1;
+			}
+			else {
+				hi = mid;
+			}
+		}
+		return lo;
+	}
+}
+
+// Index of the first key > key
+template<typename _KeyT, typename _Compare>
+SSTD_INLINE sizet _Node_Upper_Bound(const _KeyT* keys, const sizet& count, const _KeyT& key, const _Compare& comp) {
+	if constexpr (_Is_Counted_Search<_KeyT, _Compare>::value) {
+		return count - _Count_Keys<true>(keys, count, key);
+	}
+	else {
+		sizet lo = 0, hi = count;
+		while (lo < hi) {
+			const sizet mid = (lo + hi) / 2;
+			if (!comp(key, keys[mid])) {
+				lo = mid + 1;
+			}
+			else {
+				hi = mid;
+			}
+		}
+		return lo;
+	}
+}
+
+// -----------------------------------------
+//
+//   Nodes
+//
+// -----------------------------------------
+
+// How many keys a node holds
+// The keys of a node fill about 4 cache lines, so one node is a handful of sequential loads
+// ( and the prefetcher picks it up ) instead of a pointer chase per key
+// Always even, between 8 and 64 keys
+SSTD_CONSTEXPR sizet _BTree_Node_Keys(const sizet& key_size) {
+	return (256 / key_size < 8 ? 8 : (256 / key_size > 64 ? 64 : 256 / key_size)) & ~static_cast<sizet>(1);
+}
+
+// Leaves hold the keys and the elements in 2 separate arrays, so searching a node only touches keys
+// They are linked both ways, a range scan never goes back up the tree
+template<typename _KeyT, typename _EltT, sizet _Keys>
+struct _BTree_Leaf {
+	alignas(_KeyT) unsigned char key_memory[sizeof(_KeyT) * _Keys];
+	alignas(_EltT) unsigned char elt_memory[sizeof(_EltT) * _Keys];
+	_BTree_Leaf* prev;
+	_BTree_Leaf* next;
+	uint32 count;
+
+	SSTD_INLINE _KeyT* Keys() noexcept {
+		return reinterpret_cast<_KeyT*>(key_memory);
+	}
+	SSTD_INLINE const _KeyT* Keys() const noexcept {
+		return reinterpret_cast<const _KeyT*>(key_memory);
+	}
+	SSTD_INLINE _EltT* Elts() noexcept {
+		return reinterpret_cast<_EltT*>(elt_memory);
+	}
+	SSTD_INLINE const _EltT* Elts() const noexcept {
+		return reinterpret_cast<const _EltT*>(elt_memory);
+	}
+};
+
+// Sets don't have elements
+template<typename _KeyT, sizet _Keys>
+struct _BTree_Leaf<_KeyT, void, _Keys> {
+	alignas(_KeyT) unsigned char key_memory[sizeof(_KeyT) * _Keys];
+	_BTree_Leaf* prev;
+	_BTree_Leaf* next;
+	uint32 count;
+
+	SSTD_INLINE _KeyT* Keys() noexcept {
+		return reinterpret_cast<_KeyT*>(key_memory);
+	}
+	SSTD_INLINE const _KeyT* Keys() const noexcept {
+		return reinterpret_cast<const _KeyT*>(key_memory);
+	}
+};
+
+// count keys and count + 1 children
+// keys[i] is <= every key under children[i + 1], and > every key under children[i]
+// ( The children are leaves at the last level, inner nodes otherwise )
+template<typename _KeyT, sizet _Keys>
+struct _BTree_Inner {
+	alignas(_KeyT) unsigned char key_memory[sizeof(_KeyT) * _Keys];
+	void* children[_Keys + 1];
+	uint32 count;
+
+	SSTD_INLINE _KeyT* Keys() noexcept {
+		return reinterpret_cast<_KeyT*>(key_memory);
+	}
+	SSTD_INLINE const _KeyT* Keys() const noexcept {
+		return reinterpret_cast<const _KeyT*>(key_memory);
+	}
+};
+
+// -----------------------------------------
+//
+//   B+tree
+//
+// -----------------------------------------
+
+// The shared core of sstd::btree_map and sstd::btree_set ( _EltT is void for the set )
+//
+// A B+tree: every key lives in a leaf, the inner nodes only hold copies of keys to route the searches
+// A position is a leaf and an index inside of it, the end position is a null leaf
+//
+// Nodes don't know their parents, inserts and erases remember the path they went down instead
+template<typename _KeyT, typename _EltT, typename _Compare>
+class _BTree {
+protected:
+	static SSTD_CONSTEXPR sizet _Keys = _BTree_Node_Keys(sizeof(_KeyT));
+	// Every node except the root is kept at least half full
+	// ( Except after appends, see _Emplace )
+	static SSTD_CONSTEXPR sizet _Min_Keys = _Keys / 2;
+	// Even half full nodes of 8 keys reach 2^64 keys way before this
+	static SSTD_CONSTEXPR sizet _Max_Height = 64;
+	static SSTD_CONSTEXPR bool _Has_Elts = !std::is_void<_EltT>::value;
+
+	using _Leaf = _BTree_Leaf<_KeyT, _EltT, _Keys>;
+	using _Inner = _BTree_Inner<_KeyT, _Keys>;
+
+	// The inner nodes on the way down to a leaf, and which child got taken in each one
+	struct _Path {
+		_Inner* nodes[_Max_Height];
+		sizet inds[_Max_Height];
+	};
+public:
+	_BTree() SSTD_DEFAULT;
+
+	_BTree(const _BTree&) = delete;
+	_BTree& operator=(const _BTree&) = delete;
+
+	~_BTree() {
+		clear();
+	}
+
+	SSTD_INLINE void clear() noexcept {
+		if (m_root != nullptr) {
+			_Free_Node(m_root, m_height);
+		}
+		m_root = nullptr;
+		m_first = nullptr;
+		m_last = nullptr;
+		m_height = 0;
+		m_size = 0;
+	}
+
+	SSTD_INLINE sizet size() const noexcept {
+		return m_size;
+	}
+	SSTD_INLINE bool empty() const noexcept {
+		return m_size == 0;
+	}
+	// Levels of the tree, including the leaves
+	SSTD_INLINE sizet height() const noexcept {
+		return m_root == nullptr ? 0 : m_height + 1;
+	}
+protected:
+	void* m_root = nullptr;
+	// Levels of inner nodes above the leaves
+	sizet m_height = 0;
+	_Leaf* m_first = nullptr;
+	_Leaf* m_last = nullptr;
+	sizet m_size = 0;
+
+	const _Compare m_comp{};
+
+	// -------- Nodes --------
+
+	static SSTD_INLINE _Leaf* _New_Leaf() {
+		_Leaf* leaf = static_cast<_Leaf*>(malloc(sizeof(_Leaf)));
+		if (leaf == nullptr) {
+			throw std::bad_alloc();
+		}
+		leaf->prev = nullptr;
+		leaf->next = nullptr;
+		leaf->count = 0;
+		return leaf;
+	}
+
+	static SSTD_INLINE _Inner* _New_Inner() {
+		_Inner* inner = static_cast<_Inner*>(malloc(sizeof(_Inner)));
+		if (inner == nullptr) {
+			throw std::bad_alloc();
+		}
+		inner->count = 0;
+		return inner;
+	}
+
+	static SSTD_INLINE void _Free_Leaf(_Leaf* leaf) noexcept {
+		_Destroy_Range(leaf->Keys(), leaf->count);
+		if constexpr (_Has_Elts) {
+			_Destroy_Range(leaf->Elts(), leaf->count);
+		}
+		free(leaf);
+	}
+
+	static SSTD_INLINE void _Free_Node(void* node, const sizet& height) noexcept {
+		if (height == 0) {
+			_Free_Leaf(static_cast<_Leaf*>(node));
+			return;
+		}
+		_Inner* inner = static_cast<_Inner*>(node);
+		for (sizet i = 0; i <= inner->count; ++i) {
+			_Free_Node(inner->children[i], height - 1);
+		}
+		_Destroy_Range(inner->Keys(), inner->count);
+		free(inner);
+	}
+
+	// Move n keys ( and elements ) from src[s] to dst[d]
+	static SSTD_INLINE void _Relocate_Slots(_Leaf* dst, const sizet& d, _Leaf* src, const sizet& s, const sizet& n) {
+		_Relocate_Range(dst->Keys() + d, src->Keys() + s, n);
+		if constexpr (_Has_Elts) {
+			_Relocate_Range(dst->Elts() + d, src->Elts() + s, n);
+		}
+	}
+
+	SSTD_INLINE void _Unlink_Leaf(_Leaf* leaf) noexcept {
+		(leaf->prev ? leaf->prev->next : m_first) = leaf->next;
+		(leaf->next ? leaf->next->prev : m_last) = leaf->prev;
+	}
+
+	// -------- Lookups --------
+
+	SSTD_INLINE _Leaf* _Find_Leaf(const _KeyT& key) const {
+		void* node = m_root;
+		for (sizet h = m_height; h > 0; --h) {
+			const _Inner* inner = static_cast<const _Inner*>(node);
+			node = inner->children[_Node_Upper_Bound(inner->Keys(), inner->count, key, m_comp)];
+		}
+		return static_cast<_Leaf*>(node);
+	}
+
+	// A position past the end of its leaf is the first one of the next leaf
+	static SSTD_INLINE std::pair<_Leaf*, sizet> _Normalize(_Leaf* leaf, const sizet& ind) noexcept {
+		if (ind < leaf->count) {
+			return { leaf, ind };
+		}
+		return { leaf->next, 0 };
+	}
+
+	SSTD_INLINE std::pair<_Leaf*, sizet> _Lower_Bound(const _KeyT& key) const {
+		if (m_root == nullptr) {
+			return { nullptr, 0 };
+		}
+		_Leaf* leaf = _Find_Leaf(key);
+		return _Normalize(leaf, _Node_Lower_Bound(leaf->Keys(), leaf->count, key, m_comp));
+	}
+
+	SSTD_INLINE std::pair<_Leaf*, sizet> _Upper_Bound(const _KeyT& key) const {
+		if (m_root == nullptr) {
+			return { nullptr, 0 };
+		}
+		_Leaf* leaf = _Find_Leaf(key);
+		return _Normalize(leaf, _Node_Upper_Bound(leaf->Keys(), leaf->count, key, m_comp));
+	}
+
+	SSTD_INLINE std::pair<_Leaf*, sizet> _Find(const _KeyT& key) const {
+		if (m_root == nullptr) {
+			return { nullptr, 0 };
+		}
+		_Leaf* leaf = _Find_Leaf(key);
+		const sizet ind = _Node_Lower_Bound(leaf->Keys(), leaf->count, key, m_comp);
+		if (ind < leaf->count && !m_comp(key, leaf->Keys()[ind])) {
+			return { leaf, ind };
+		}
+		return { nullptr, 0 };
+	}
+
+	// Stepping through the leaves ( for the iterators )
+	static SSTD_INLINE void _Next(_Leaf*& leaf, sizet& ind) noexcept {
+		if (++ind == leaf->count) {
+			leaf = leaf->next;
+			ind = 0;
+		}
+	}
+	SSTD_INLINE void _Prev(_Leaf*& leaf, sizet& ind) const noexcept {
+		if (leaf == nullptr) {
+			leaf = m_last;
+			ind = leaf->count - 1;
+		}
+		else if (ind == 0) {
+			leaf = leaf->prev;
+			ind = leaf->count - 1;
+		}
+		else {
+			--ind;
+		}
+	}
+
+	// -------- Inserts --------
+
+	// Construct the key and the element from args, only if the key doesn't exist yet
+	// Returns the position of the key, and whether it's new
+	template<typename _KeyArg, typename ... _Args>
+	std::pair<std::pair<_Leaf*, sizet>, bool> _Emplace(_KeyArg&& key, _Args&& ...args) {
+		if (m_root == nullptr) {
+			_Leaf* leaf = _New_Leaf();
+			m_root = leaf;
+			m_first = leaf;
+			m_last = leaf;
+		}
+
+		_Path path;
+		void* node = m_root;
+		for (sizet h = 0; h < m_height; ++h) {
+			_Inner* inner = static_cast<_Inner*>(node);
+			const sizet ind = _Node_Upper_Bound(inner->Keys(), inner->count, static_cast<const _KeyT&>(key), m_comp);
+			path.nodes[h] = inner;
+			path.inds[h] = ind;
+			node = inner->children[ind];
+		}
+		_Leaf* leaf = static_cast<_Leaf*>(node);
+		const sizet pos = _Node_Lower_Bound(leaf->Keys(), leaf->count, static_cast<const _KeyT&>(key), m_comp);
+		if (pos < leaf->count && !m_comp(key, leaf->Keys()[pos])) {
+			return { { leaf, pos }, false };
+		}
+
+		if (leaf->count < _Keys) {
+			_Relocate_Slots(leaf, pos + 1, leaf, pos, leaf->count - pos);
+			_Construct_Slot(leaf, pos, std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+			return { { leaf, pos }, true };
+		}
+
+		// Appending past the last key of the tree ( time ordered keys ) starts a new leaf,
+		// instead of splitting this one in half and leaving half empty leaves behind forever
+		if (pos == _Keys && leaf->next == nullptr) {
+			_Leaf* right = _New_Leaf();
+			try {
+				_Construct_Slot(right, 0, std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+			}
+			catch (...) {
+				free(right);
+				throw;
+			}
+			_Link_After(leaf, right);
+			_Insert_Parent(path, m_height, leaf, _KeyT(right->Keys()[0]), right);
+			return { { right, 0 }, true };
+		}
+
+		// Split the leaf in half first, then insert into the half the key belongs in
+		// ( So if constructing throws, the tree is still whole )
+		_Leaf* right = _New_Leaf();
+		_Relocate_Slots(right, 0, leaf, _Min_Keys, _Keys - _Min_Keys);
+		right->count = static_cast<uint32>(_Keys - _Min_Keys);
+		leaf->count = static_cast<uint32>(_Min_Keys);
+		_Link_After(leaf, right);
+		_Insert_Parent(path, m_height, leaf, _KeyT(right->Keys()[0]), right);
+
+		_Leaf* target = pos <= _Min_Keys ? leaf : right;
+		const sizet ind = pos <= _Min_Keys ? pos : pos - _Min_Keys;
+		_Relocate_Slots(target, ind + 1, target, ind, target->count - ind);
+		_Construct_Slot(target, ind, std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+		return { { target, ind }, true };
+	}
+
+	// The slot at ind has to be raw memory, and the leaf gets one more key
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE void _Construct_Slot(_Leaf* leaf, const sizet& ind, _KeyArg&& key, _Args&& ...args) {
+		try {
+			new (leaf->Keys() + ind) _KeyT(std::forward<_KeyArg>(key));
+			if constexpr (_Has_Elts) {
+				try {
+					new (leaf->Elts() + ind) _EltT(std::forward<_Args>(args)...);
+				}
+				catch (...) {
+					leaf->Keys()[ind].~_KeyT();
+					throw;
+				}
+			}
+		}
+		catch (...) {
+			// Close the gap again
+			_Relocate_Slots(leaf, ind, leaf, ind + 1, leaf->count - ind);
+			throw;
+		}
+		++leaf->count;
+		++m_size;
+	}
+
+	SSTD_INLINE void _Link_After(_Leaf* leaf, _Leaf* right) noexcept {
+		right->prev = leaf;
+		right->next = leaf->next;
+		(leaf->next ? leaf->next->prev : m_last) = right;
+		leaf->next = right;
+	}
+
+	// right was split off of left, which is a child of the inner node at level - 1 of path ( or the root )
+	// sep is the first key of right
+	void _Insert_Parent(_Path& path, const sizet& level, void* left, _KeyT&& sep, void* right) {
+		if (level == 0) {
+			_Inner* root = _New_Inner();
+			new (root->Keys()) _KeyT(std::move(sep));
+			root->children[0] = left;
+			root->children[1] = right;
+			root->count = 1;
+			m_root = root;
+			++m_height;
+			return;
+		}
+
+		_Inner* node = path.nodes[level - 1];
+		const sizet i = path.inds[level - 1];
+		_KeyT* keys = node->Keys();
+		if (node->count < _Keys) {
+			_Relocate_Range(keys + i + 1, keys + i, node->count - i);
+			new (keys + i) _KeyT(std::move(sep));
+			std::memmove(node->children + i + 2, node->children + i + 1, (node->count - i) * sizeof(void*));
+			node->children[i + 1] = right;
+			++node->count;
+			return;
+		}
+
+		// Full, split it around the middle of the _Keys + 1 keys, the middle key moves up
+		// ( sep goes in at i, right at i + 1 )
+		_Inner* other = _New_Inner();
+		_KeyT* other_keys = other->Keys();
+		constexpr sizet half = _Keys / 2;
+		alignas(_KeyT) unsigned char up_memory[sizeof(_KeyT)];
+		_KeyT* up = reinterpret_cast<_KeyT*>(up_memory);
+		if (i < half) {
+			_Relocate_Range(up, keys + half - 1, 1);
+			_Relocate_Range(other_keys, keys + half, _Keys - half);
+			std::memcpy(other->children, node->children + half, (_Keys - half + 1) * sizeof(void*));
+			_Relocate_Range(keys + i + 1, keys + i, half - 1 - i);
+			new (keys + i) _KeyT(std::move(sep));
+			std::memmove(node->children + i + 2, node->children + i + 1, (half - 1 - i) * sizeof(void*));
+			node->children[i + 1] = right;
+		}
+		else if (i == half) {
+			new (up) _KeyT(std::move(sep));
+			_Relocate_Range(other_keys, keys + half, _Keys - half);
+			other->children[0] = right;
+			std::memcpy(other->children + 1, node->children + half + 1, (_Keys - half) * sizeof(void*));
+		}
+		else {
+			const sizet j = i - half - 1;
+			_Relocate_Range(up, keys + half, 1);
+			_Relocate_Range(other_keys, keys + half + 1, j);
+			new (other_keys + j) _KeyT(std::move(sep));
+			_Relocate_Range(other_keys + j + 1, keys + i, _Keys - i);
+			std::memcpy(other->children, node->children + half + 1, (j + 1) * sizeof(void*));
+			other->children[j + 1] = right;
+			std::memcpy(other->children + j + 2, node->children + i + 1, (_Keys - i) * sizeof(void*));
+		}
+		node->count = static_cast<uint32>(half);
+		other->count = static_cast<uint32>(_Keys - half);
+
+		_Insert_Parent(path, level - 1, node, std::move(*up), other);
+		up->~_KeyT();
+	}
+
+	// -------- Erases --------
+
+	// Returns whether the key existed
+	bool _Erase(const _KeyT& key) {
+		if (m_root == nullptr) {
+			return false;
+		}
+		_Path path;
+		void* node = m_root;
+		for (sizet h = 0; h < m_height; ++h) {
+			_Inner* inner = static_cast<_Inner*>(node);
+			const sizet ind = _Node_Upper_Bound(inner->Keys(), inner->count, key, m_comp);
+			path.nodes[h] = inner;
+			path.inds[h] = ind;
+			node = inner->children[ind];
+		}
+		_Leaf* leaf = static_cast<_Leaf*>(node);
+		const sizet pos = _Node_Lower_Bound(leaf->Keys(), leaf->count, key, m_comp);
+		if (pos == leaf->count || m_comp(key, leaf->Keys()[pos])) {
+			return false;
+		}
+
+		leaf->Keys()[pos].~_KeyT();
+		if constexpr (_Has_Elts) {
+			leaf->Elts()[pos].~_EltT();
+		}
+		_Relocate_Slots(leaf, pos, leaf, pos + 1, leaf->count - pos - 1);
+		--leaf->count;
+		--m_size;
+
+		if (m_height == 0) {
+			if (leaf->count == 0) {
+				clear();
+			}
+			return true;
+		}
+		if (leaf->count < _Min_Keys) {
+			_Rebalance_Leaf(path, leaf);
+		}
+		return true;
+	}
+
+	// Refill a leaf that dropped under _Min_Keys, from a sibling if it has keys to spare, otherwise merge the 2
+	// ( Separators don't need to be existing keys, so erasing the first key of a leaf leaves its separator alone )
+	void _Rebalance_Leaf(_Path& path, _Leaf* leaf) {
+		_Inner* parent = path.nodes[m_height - 1];
+		const sizet ci = path.inds[m_height - 1];
+		_Leaf* left = ci > 0 ? static_cast<_Leaf*>(parent->children[ci - 1]) : nullptr;
+		_Leaf* right = ci < parent->count ? static_cast<_Leaf*>(parent->children[ci + 1]) : nullptr;
+
+		if (left != nullptr && left->count > _Min_Keys) {
+			_Relocate_Slots(leaf, 1, leaf, 0, leaf->count);
+			_Relocate_Slots(leaf, 0, left, left->count - 1, 1);
+			--left->count;
+			++leaf->count;
+			parent->Keys()[ci - 1] = leaf->Keys()[0];
+			return;
+		}
+		if (right != nullptr && right->count > _Min_Keys) {
+			_Relocate_Slots(leaf, leaf->count, right, 0, 1);
+			_Relocate_Slots(right, 0, right, 1, right->count - 1);
+			--right->count;
+			++leaf->count;
+			parent->Keys()[ci] = right->Keys()[0];
+			return;
+		}
+
+		// Merge into the left one of the 2, and drop the separator between them
+		const sizet ki = left == nullptr ? ci : ci - 1;
+		if (left == nullptr) {
+			left = leaf;
+			leaf = right;
+		}
+		_Relocate_Slots(left, left->count, leaf, 0, leaf->count);
+		left->count += leaf->count;
+		leaf->count = 0;
+		_Unlink_Leaf(leaf);
+		free(leaf);
+		parent->Keys()[ki].~_KeyT();
+		_Remove_Inner_Slot(path, m_height - 1, ki);
+	}
+
+	// Remove key ki ( already raw memory ) and child ki + 1 from the inner node at level of path
+	void _Remove_Inner_Slot(_Path& path, const sizet& level, const sizet& ki) {
+		_Inner* node = path.nodes[level];
+		_Relocate_Range(node->Keys() + ki, node->Keys() + ki + 1, node->count - ki - 1);
+		std::memmove(node->children + ki + 1, node->children + ki + 2, (node->count - ki - 1) * sizeof(void*));
+		--node->count;
+
+		if (level == 0) {
+			// A root with a single child is useless, that child becomes the root
+			if (node->count == 0) {
+				m_root = node->children[0];
+				free(node);
+				--m_height;
+			}
+			return;
+		}
+		if (node->count >= _Min_Keys) {
+			return;
+		}
+
+		// Same as _Rebalance_Leaf, but the separator in the parent rotates through
+		_Inner* parent = path.nodes[level - 1];
+		const sizet ci = path.inds[level - 1];
+		_Inner* left = ci > 0 ? static_cast<_Inner*>(parent->children[ci - 1]) : nullptr;
+		_Inner* right = ci < parent->count ? static_cast<_Inner*>(parent->children[ci + 1]) : nullptr;
+
+		if (left != nullptr && left->count > _Min_Keys) {
+			_Relocate_Range(node->Keys() + 1, node->Keys(), node->count);
+			std::memmove(node->children + 1, node->children, (node->count + 1) * sizeof(void*));
+			_Relocate_Range(node->Keys(), parent->Keys() + ci - 1, 1);
+			_Relocate_Range(parent->Keys() + ci - 1, left->Keys() + left->count - 1, 1);
+			node->children[0] = left->children[left->count];
+			--left->count;
+			++node->count;
+			return;
+		}
+		if (right != nullptr && right->count > _Min_Keys) {
+			_Relocate_Range(node->Keys() + node->count, parent->Keys() + ci, 1);
+			node->children[node->count + 1] = right->children[0];
+			_Relocate_Range(parent->Keys() + ci, right->Keys(), 1);
+			_Relocate_Range(right->Keys(), right->Keys() + 1, right->count - 1);
+			std::memmove(right->children, right->children + 1, right->count * sizeof(void*));
+			--right->count;
+			++node->count;
+			return;
+		}
+
+		const sizet ki_up = left == nullptr ? ci : ci - 1;
+		if (left == nullptr) {
+			left = node;
+			node = right;
+		}
+		_Relocate_Range(left->Keys() + left->count, parent->Keys() + ki_up, 1);
+		_Relocate_Range(left->Keys() + left->count + 1, node->Keys(), node->count);
+		std::memcpy(left->children + left->count + 1, node->children, (node->count + 1) * sizeof(void*));
+		left->count += node->count + 1;
+		free(node);
+		_Remove_Inner_Slot(path, level - 1, ki_up);
+	}
+};
+
+SSTD_END
+
+#endif
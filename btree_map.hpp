@@ -0,0 +1,373 @@
+#ifndef SSTD_BTREE_MAP_INCLUDED
+#define SSTD_BTREE_MAP_INCLUDED
+
+#include "core.hpp"
+#include "Iterator.hpp"
+#include "btree.hpp"
+
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+SSTD_BEGIN
+
+// -----------------------------------------
+//
+//   Iterator declarations
+//
+// -----------------------------------------
+
+template<typename _KeyT, typename _EltT, typename _Compare>
+class _BTree_Map_Iterator;
+template<typename _KeyT, typename _EltT, typename _Compare>
+class _BTree_Map_Const_Iterator;
+
+// An ordered map, for when std::map is too slow to walk
+// std::map is a red-black tree, one node ( and one cache miss ) per key
+// This sstd::btree_map is a B+tree, with nodes of a few cache lines holding up to 64 keys each ( see btree.hpp )
+// And all the keys live in linked leaves, so a range scan is mostly a sequential read
+//
+// Integer keys with the default std::less get searched inside of a node with SIMD compares
+//
+// The keys and the elements are stored in separate arrays, so the iterators return
+// std::pair<const Key&, Element&> ( by value ) instead of a reference to a stored pair ( it-> goes through _Arrow_Proxy )
+// Inserts and erases move keys around inside of the nodes, so they invalidate the iterators
+
+template<
+	typename _KeyT,	// Key type
+	typename _EltT,		// Element type
+	typename _Compare = std::less<_KeyT> // Key ordering
+>
+class btree_map : public _BTree<_KeyT, _EltT, _Compare> {
+public:
+	friend class _BTree_Map_Iterator<_KeyT, _EltT, _Compare>;
+	friend class _BTree_Map_Const_Iterator<_KeyT, _EltT, _Compare>;
+	using iterator = _BTree_Map_Iterator<_KeyT, _EltT, _Compare>;
+	using const_iterator = _BTree_Map_Const_Iterator<_KeyT, _EltT, _Compare>;
+private:
+	using _Tree = _BTree<_KeyT, _EltT, _Compare>;
+	using typename _Tree::_Leaf;
+	using _Tree::m_first;
+	using _Tree::_Find;
+	using _Tree::_Lower_Bound;
+	using _Tree::_Upper_Bound;
+	using _Tree::_Emplace;
+	using _Tree::_Erase;
+	using _Tree::_Next;
+	using _Tree::_Prev;
+public:
+
+	// Default constructor
+	btree_map() SSTD_DEFAULT;
+
+	// Constructor that initialize using a initializer list
+	// std::pair(Key, Element)
+	btree_map(std::initializer_list<std::pair<_KeyT, _EltT> > list) {
+		for (const std::pair<_KeyT, _EltT>& pair : list) {
+			_Insert_Or_Assign(pair.first, pair.second);
+		}
+	}
+
+	// Insert the element, or overwrite it if the key already exists
+	SSTD_INLINE std::pair<iterator, bool> insert(const _KeyT& key, const _EltT& elt) {
+		return _Insert_Or_Assign(key, elt);
+	}
+	SSTD_INLINE std::pair<iterator, bool> insert(const _KeyT& key, _EltT&& elt) {
+		return _Insert_Or_Assign(key, std::move(elt));
+	}
+	SSTD_INLINE std::pair<iterator, bool> insert(const std::pair<_KeyT, _EltT>& pair) {
+		return _Insert_Or_Assign(pair.first, pair.second);
+	}
+	SSTD_INLINE std::pair<iterator, bool> insert(std::pair<_KeyT, _EltT>&& pair) {
+		return _Insert_Or_Assign(std::move(pair.first), std::move(pair.second));
+	}
+
+	// Construct the key and the element directly into the tree
+	// The first argument is the key, the rest are passed to the constructor of the element
+	// Nothing gets constructed if the key already exists
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> emplace(_KeyArg&& key, _Args&& ...args) {
+		return _Try_Emplace(std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+	}
+
+	// Same as emplace, but the key is always a _KeyT
+	template<typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> try_emplace(const _KeyT& key, _Args&& ...args) {
+		return _Try_Emplace(key, std::forward<_Args>(args)...);
+	}
+	template<typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> try_emplace(_KeyT&& key, _Args&& ...args) {
+		return _Try_Emplace(std::move(key), std::forward<_Args>(args)...);
+	}
+
+	// Assign elt if the key already exists, otherwise construct it in place
+	template<typename _TE>
+	SSTD_INLINE std::pair<iterator, bool> insert_or_assign(const _KeyT& key, _TE&& elt) {
+		return _Insert_Or_Assign(key, std::forward<_TE>(elt));
+	}
+	template<typename _TE>
+	SSTD_INLINE std::pair<iterator, bool> insert_or_assign(_KeyT&& key, _TE&& elt) {
+		return _Insert_Or_Assign(std::move(key), std::forward<_TE>(elt));
+	}
+
+	// Returns how many elements got erased ( 0 or 1 )
+	SSTD_INLINE sizet erase(const _KeyT& key) {
+		return _Erase(key);
+	}
+
+	// Construct a empty value into the tree if the key doesn't exist
+	SSTD_INLINE _EltT& operator[](const _KeyT& key) {
+		return _Try_Emplace(key).first.value();
+	}
+	SSTD_INLINE _EltT& operator[](_KeyT&& key) {
+		return _Try_Emplace(std::move(key)).first.value();
+	}
+
+	// Lookups
+	SSTD_INLINE iterator find(const _KeyT& key) {
+		return _Make_Iterator(_Find(key));
+	}
+	SSTD_INLINE const_iterator find(const _KeyT& key) const {
+		return _Make_Const_Iterator(_Find(key));
+	}
+
+	SSTD_INLINE bool contains(const _KeyT& key) const {
+		return _Find(key).first != nullptr;
+	}
+
+	SSTD_INLINE sizet count(const _KeyT& key) const {
+		return contains(key);
+	}
+
+	// Throws if the key doesn't exist
+	SSTD_INLINE _EltT& at(const _KeyT& key) {
+		return _Check_Key(_Find(key));
+	}
+	SSTD_INLINE const _EltT& at(const _KeyT& key) const {
+		return _Check_Key(_Find(key));
+	}
+
+	// Range queries
+	// [lower_bound(lo), lower_bound(hi)) are all the keys in [lo, hi)
+
+	// The first key >= key
+	SSTD_INLINE iterator lower_bound(const _KeyT& key) {
+		return _Make_Iterator(_Lower_Bound(key));
+	}
+	SSTD_INLINE const_iterator lower_bound(const _KeyT& key) const {
+		return _Make_Const_Iterator(_Lower_Bound(key));
+	}
+
+	// The first key > key
+	SSTD_INLINE iterator upper_bound(const _KeyT& key) {
+		return _Make_Iterator(_Upper_Bound(key));
+	}
+	SSTD_INLINE const_iterator upper_bound(const _KeyT& key) const {
+		return _Make_Const_Iterator(_Upper_Bound(key));
+	}
+
+	SSTD_INLINE iterator begin() noexcept {
+		return iterator(this, m_first, 0);
+	}
+	SSTD_INLINE const_iterator begin() const noexcept {
+		return const_iterator(this, m_first, 0);
+	}
+	SSTD_INLINE iterator end() noexcept {
+		return iterator(this, nullptr, 0);
+	}
+	SSTD_INLINE const_iterator end() const noexcept {
+		return const_iterator(this, nullptr, 0);
+	}
+
+	SSTD_INLINE const_iterator cbegin() const noexcept {
+		return begin();
+	}
+	SSTD_INLINE const_iterator cend() const noexcept {
+		return end();
+	}
+private:
+	SSTD_INLINE iterator _Make_Iterator(const std::pair<_Leaf*, sizet>& pos) noexcept {
+		return iterator(this, pos.first, pos.second);
+	}
+	SSTD_INLINE const_iterator _Make_Const_Iterator(const std::pair<_Leaf*, sizet>& pos) const noexcept {
+		return const_iterator(this, pos.first, pos.second);
+	}
+
+	// Construct the element in place, only if the key doesn't exist yet
+	// Returns the iterator to the element with the key, and whether it was inserted
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> _Try_Emplace(_KeyArg&& key, _Args&& ...args) {
+		const auto res = _Emplace(std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+		return { _Make_Iterator(res.first), res.second };
+	}
+
+	// Assign to the element if the key exists, otherwise construct it in place
+	template<typename _KeyArg, typename _TE>
+	SSTD_INLINE std::pair<iterator, bool> _Insert_Or_Assign(_KeyArg&& key, _TE&& elt) {
+		std::pair<iterator, bool> res = _Try_Emplace(std::forward<_KeyArg>(key), std::forward<_TE>(elt));
+		if (!res.second) {
+			res.first.value() = std::forward<_TE>(elt);
+		}
+		return res;
+	}
+
+	SSTD_INLINE _EltT& _Check_Key(const std::pair<_Leaf*, sizet>& pos) const {
+		if (pos.first == nullptr) {
+			throw std::out_of_range("BTree map key not found");
+		}
+		return pos.first->Elts()[pos.second];
+	}
+};
+
+// -----------------------------------------
+//
+//   Bidirectional Iterator
+//
+// -----------------------------------------
+
+template<
+	typename _KeyT,
+	typename _EltT,
+	typename _Compare
+>
+class _BTree_Map_Iterator : public bidirectional_iterator<std::pair<const _KeyT, _EltT> > {
+	friend class btree_map<_KeyT, _EltT, _Compare>;
+	friend class _BTree_Map_Const_Iterator<_KeyT, _EltT, _Compare>;
+	using _Leaf = _BTree_Leaf<_KeyT, _EltT, _BTree_Node_Keys(sizeof(_KeyT))>;
+public:
+	using value_type = std::pair<const _KeyT, _EltT>;
+	// A pair of references into the leaf, not a reference to a stored pair
+	using reference = std::pair<const _KeyT&, _EltT&>;
+	using pointer = _Arrow_Proxy<reference>;
+
+	_BTree_Map_Iterator(btree_map<_KeyT, _EltT, _Compare>* _map, _Leaf* leaf, sizet ind) :
+		m_map(_map), m_leaf(leaf), m_ind(ind) {
+
+	}
+
+	SSTD_INLINE _BTree_Map_Iterator& operator++() noexcept {
+		btree_map<_KeyT, _EltT, _Compare>::_Next(m_leaf, m_ind);
+		return *this;
+	}
+	SSTD_INLINE _BTree_Map_Iterator operator++(int) noexcept {
+		_BTree_Map_Iterator tmp = *this;
+		btree_map<_KeyT, _EltT, _Compare>::_Next(m_leaf, m_ind);
+		return tmp;
+	}
+
+	SSTD_INLINE _BTree_Map_Iterator& operator--() noexcept {
+		m_map->_Prev(m_leaf, m_ind);
+		return *this;
+	}
+	SSTD_INLINE _BTree_Map_Iterator operator--(int) noexcept {
+		_BTree_Map_Iterator tmp = *this;
+		m_map->_Prev(m_leaf, m_ind);
+		return tmp;
+	}
+
+	SSTD_INLINE reference operator*() const noexcept {
+		return { key(), value() };
+	}
+	SSTD_INLINE pointer operator->() const noexcept {
+		return { **this };
+	}
+
+	SSTD_INLINE const _KeyT& key() const noexcept {
+		return m_leaf->Keys()[m_ind];
+	}
+	SSTD_INLINE _EltT& value() const noexcept {
+		return m_leaf->Elts()[m_ind];
+	}
+
+	SSTD_INLINE bool operator==(const _BTree_Map_Iterator& other) const noexcept {
+		return this->m_leaf == other.m_leaf && this->m_ind == other.m_ind;
+	}
+
+	SSTD_INLINE bool operator!=(const _BTree_Map_Iterator& other) const noexcept {
+		return this->m_leaf != other.m_leaf || this->m_ind != other.m_ind;
+	}
+private:
+	btree_map<_KeyT, _EltT, _Compare>* m_map;
+	_Leaf* m_leaf;
+	sizet m_ind;
+};
+
+// -----------------------------------------
+//
+//   Const Bidirectional Iterator
+//
+// -----------------------------------------
+
+template<
+	typename _KeyT,
+	typename _EltT,
+	typename _Compare
+>
+class _BTree_Map_Const_Iterator : public const_bidirectional_iterator<std::pair<const _KeyT, _EltT> > {
+	friend class btree_map<_KeyT, _EltT, _Compare>;
+	using _Leaf = _BTree_Leaf<_KeyT, _EltT, _BTree_Node_Keys(sizeof(_KeyT))>;
+public:
+	using value_type = std::pair<const _KeyT, _EltT>;
+	using reference = std::pair<const _KeyT&, const _EltT&>;
+	using pointer = _Arrow_Proxy<reference>;
+
+	_BTree_Map_Const_Iterator(const btree_map<_KeyT, _EltT, _Compare>* _map, _Leaf* leaf, sizet ind) :
+		m_map(_map), m_leaf(leaf), m_ind(ind) {
+
+	}
+	_BTree_Map_Const_Iterator(_BTree_Map_Iterator<_KeyT, _EltT, _Compare> itr) :
+		m_map(itr.m_map), m_leaf(itr.m_leaf), m_ind(itr.m_ind) {
+
+	}
+
+	SSTD_INLINE _BTree_Map_Const_Iterator& operator++() noexcept {
+		btree_map<_KeyT, _EltT, _Compare>::_Next(m_leaf, m_ind);
+		return *this;
+	}
+	SSTD_INLINE _BTree_Map_Const_Iterator operator++(int) noexcept {
+		_BTree_Map_Const_Iterator tmp = *this;
+		btree_map<_KeyT, _EltT, _Compare>::_Next(m_leaf, m_ind);
+		return tmp;
+	}
+
+	SSTD_INLINE _BTree_Map_Const_Iterator& operator--() noexcept {
+		m_map->_Prev(m_leaf, m_ind);
+		return *this;
+	}
+	SSTD_INLINE _BTree_Map_Const_Iterator operator--(int) noexcept {
+		_BTree_Map_Const_Iterator tmp = *this;
+		m_map->_Prev(m_leaf, m_ind);
+		return tmp;
+	}
+
+	SSTD_INLINE reference operator*() const noexcept {
+		return { key(), value() };
+	}
+	SSTD_INLINE pointer operator->() const noexcept {
+		return { **this };
+	}
+
+	SSTD_INLINE const _KeyT& key() const noexcept {
+		return m_leaf->Keys()[m_ind];
+	}
+	SSTD_INLINE const _EltT& value() const noexcept {
+		return m_leaf->Elts()[m_ind];
+	}
+
+	SSTD_INLINE bool operator==(const _BTree_Map_Const_Iterator& other) const noexcept {
+		return this->m_leaf == other.m_leaf && this->m_ind == other.m_ind;
+	}
+
+	SSTD_INLINE bool operator!=(const _BTree_Map_Const_Iterator& other) const noexcept {
+		return this->m_leaf != other.m_leaf || this->m_ind != other.m_ind;
+	}
+private:
+	const btree_map<_KeyT, _EltT, _Compare>* m_map;
+	_Leaf* m_leaf;
+	sizet m_ind;
+};
+
+SSTD_END
+
+#endif
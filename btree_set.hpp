@@ -0,0 +1,184 @@
+#ifndef SSTD_BTREE_SET_INCLUDED
+#define SSTD_BTREE_SET_INCLUDED
+
+#include "core.hpp"
+#include "Iterator.hpp"
+#include "btree.hpp"
+
+#include <functional>
+#include <initializer_list>
+#include <utility>
+
+SSTD_BEGIN
+
+template<typename _KeyT, typename _Compare>
+class _BTree_Set_Iterator;
+
+// A sstd::btree_map without the elements ( see btree.hpp )
+// The leaves only hold keys, so a range scan reads nothing else
+//
+// The keys can't be modified in place ( that would break the order ), so every iterator is a const one
+
+template<
+	typename _KeyT,	// Key type
+	typename _Compare = std::less<_KeyT> // Key ordering
+>
+class btree_set : public _BTree<_KeyT, void, _Compare> {
+public:
+	friend class _BTree_Set_Iterator<_KeyT, _Compare>;
+	using iterator = _BTree_Set_Iterator<_KeyT, _Compare>;
+	using const_iterator = iterator;
+private:
+	using _Tree = _BTree<_KeyT, void, _Compare>;
+	using typename _Tree::_Leaf;
+	using _Tree::m_first;
+	using _Tree::_Find;
+	using _Tree::_Lower_Bound;
+	using _Tree::_Upper_Bound;
+	using _Tree::_Emplace;
+	using _Tree::_Erase;
+	using _Tree::_Next;
+	using _Tree::_Prev;
+public:
+
+	// Default constructor
+	btree_set() SSTD_DEFAULT;
+
+	// Constructor that initialize using a initializer list
+	btree_set(std::initializer_list<_KeyT> list) {
+		for (const _KeyT& key : list) {
+			_Emplace(key);
+		}
+	}
+
+	// Returns the iterator to the key, and whether it's new
+	SSTD_INLINE std::pair<iterator, bool> insert(const _KeyT& key) {
+		return _Insert(key);
+	}
+	SSTD_INLINE std::pair<iterator, bool> insert(_KeyT&& key) {
+		return _Insert(std::move(key));
+	}
+
+	// Construct the key from args
+	// ( It's constructed before the lookup, because it needs to be compared )
+	template<typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> emplace(_Args&& ...args) {
+		return _Insert(_KeyT(std::forward<_Args>(args)...));
+	}
+
+	// Returns how many keys got erased ( 0 or 1 )
+	SSTD_INLINE sizet erase(const _KeyT& key) {
+		return _Erase(key);
+	}
+
+	// Lookups
+	SSTD_INLINE iterator find(const _KeyT& key) const {
+		return _Make_Iterator(_Find(key));
+	}
+
+	SSTD_INLINE bool contains(const _KeyT& key) const {
+		return _Find(key).first != nullptr;
+	}
+
+	SSTD_INLINE sizet count(const _KeyT& key) const {
+		return contains(key);
+	}
+
+	// Range queries
+	// [lower_bound(lo), lower_bound(hi)) are all the keys in [lo, hi)
+
+	// The first key >= key
+	SSTD_INLINE iterator lower_bound(const _KeyT& key) const {
+		return _Make_Iterator(_Lower_Bound(key));
+	}
+	// The first key > key
+	SSTD_INLINE iterator upper_bound(const _KeyT& key) const {
+		return _Make_Iterator(_Upper_Bound(key));
+	}
+
+	SSTD_INLINE iterator begin() const noexcept {
+		return iterator(this, m_first, 0);
+	}
+	SSTD_INLINE iterator end() const noexcept {
+		return iterator(this, nullptr, 0);
+	}
+	SSTD_INLINE iterator cbegin() const noexcept {
+		return begin();
+	}
+	SSTD_INLINE iterator cend() const noexcept {
+		return end();
+	}
+private:
+	SSTD_INLINE iterator _Make_Iterator(const std::pair<_Leaf*, sizet>& pos) const noexcept {
+		return iterator(this, pos.first, pos.second);
+	}
+
+	template<typename _KeyArg>
+	SSTD_INLINE std::pair<iterator, bool> _Insert(_KeyArg&& key) {
+		const auto res = _Emplace(std::forward<_KeyArg>(key));
+		return { _Make_Iterator(res.first), res.second };
+	}
+};
+
+// -----------------------------------------
+//
+//   Const Bidirectional Iterator
+//
+// -----------------------------------------
+
+template<
+	typename _KeyT,
+	typename _Compare
+>
+class _BTree_Set_Iterator : public const_bidirectional_iterator<_KeyT> {
+	friend class btree_set<_KeyT, _Compare>;
+	using _Leaf = _BTree_Leaf<_KeyT, void, _BTree_Node_Keys(sizeof(_KeyT))>;
+public:
+	_BTree_Set_Iterator(const btree_set<_KeyT, _Compare>* _set, _Leaf* leaf, sizet ind) :
+		m_set(_set), m_leaf(leaf), m_ind(ind) {
+
+	}
+
+	SSTD_INLINE _BTree_Set_Iterator& operator++() noexcept {
+		btree_set<_KeyT, _Compare>::_Next(m_leaf, m_ind);
+		return *this;
+	}
+	SSTD_INLINE _BTree_Set_Iterator operator++(int) noexcept {
+		_BTree_Set_Iterator tmp = *this;
+		btree_set<_KeyT, _Compare>::_Next(m_leaf, m_ind);
+		return tmp;
+	}
+
+	SSTD_INLINE _BTree_Set_Iterator& operator--() noexcept {
+		m_set->_Prev(m_leaf, m_ind);
+		return *this;
+	}
+	SSTD_INLINE _BTree_Set_Iterator operator--(int) noexcept {
+		_BTree_Set_Iterator tmp = *this;
+		m_set->_Prev(m_leaf, m_ind);
+		return tmp;
+	}
+
+	SSTD_INLINE const _KeyT& operator*() const noexcept {
+		return m_leaf->Keys()[m_ind];
+	}
+	SSTD_INLINE const _KeyT* operator->() const noexcept {
+		return m_leaf->Keys() + m_ind;
+	}
+
+	SSTD_INLINE bool operator==(const _BTree_Set_Iterator& other) const noexcept {
+		return this->m_leaf == other.m_leaf && this->m_ind == other.m_ind;
+	}
+
+	SSTD_INLINE bool operator!=(const _BTree_Set_Iterator& other) const noexcept {
+		return this->m_leaf != other.m_leaf || this->m_ind != other.m_ind;
+	}
+private:
+	const btree_set<_KeyT, _Compare>* m_set;
+	_Leaf* m_leaf;
+	sizet m_ind;
+};
+
+SSTD_END
+
+#endif
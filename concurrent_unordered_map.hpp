@@ -0,0 +1,263 @@
+#ifndef SSTD_CONCURRENT_UNORDERED_MAP_INCLUDED
+#define SSTD_CONCURRENT_UNORDERED_MAP_INCLUDED
+
+#include "core.hpp"
+#include "unordered_map.hpp"
+
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <utility>
+
+SSTD_BEGIN
+
+// A sstd::unordered_map split into _Shards independent tables ( shards ), each one with its own lock
+// The shard of a key is picked by the high bits of its hash,
+// so threads working on different keys almost never wait for the same lock
+// Readers of a shard share its lock, writers lock it exclusively
+//
+// The elements can only be touched while the lock of their shard is held,
+// so find copies the element out, and upsert / for_each take a functor that runs under the lock
+
+template<
+	typename _KeyT,	// Key type
+	typename _EltT,		// Element type
+	typename _Hash = hash<_KeyT>, // Hash function
+	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash>, // probing function
+	sizet _Shards = 64 // Amount of shards ( power of 2 )
+>
+class concurrent_unordered_map {
+	static_assert(_Shards > 0 && (_Shards & (_Shards - 1)) == 0, "The amount of shards needs to be a power of 2");
+	static_assert(_Shards <= (1 << 16), "The shard is picked using 16 bits of the hash");
+public:
+	using map_type = unordered_map<_KeyT, _EltT, _Hash, _ProbT>;
+private:
+	// Every shard gets its own cache line(s), so the locks don't false share
+	struct alignas(64) _Shard {
+		mutable std::shared_mutex mutex;
+		map_type map;
+	};
+public:
+
+	// Default constructor
+	concurrent_unordered_map() {
+		_Share_Seed();
+	}
+
+	// Constructor that reserves _size slots in total
+	SSTD_EXPLICIT concurrent_unordered_map(const sizet& _size) {
+		_Share_Seed();
+		reserve(_size);
+	}
+
+	concurrent_unordered_map(const concurrent_unordered_map&) = delete;
+	concurrent_unordered_map& operator=(const concurrent_unordered_map&) = delete;
+
+	// Copy the element into out if the key exists
+	SSTD_INLINE bool find(const _KeyT& key, _EltT& out) const {
+		const sizet hash = _Hash_Key(key);
+		const _Shard& shard = _Get_Shard(hash);
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
+		const sizet ind = shard.map._Find_Index(key, _Shard_Hash(shard, key, hash));
+		if (ind == shard.map.m_capacity) {
+			return false;
+		}
+		out = shard.map._Elt_At(ind);
+		return true;
+	}
+
+	SSTD_INLINE bool contains(const _KeyT& key) const {
+		const sizet hash = _Hash_Key(key);
+		const _Shard& shard = _Get_Shard(hash);
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
+		return shard.map._Find_Index(key, _Shard_Hash(shard, key, hash)) != shard.map.m_capacity;
+	}
+
+	SSTD_INLINE sizet count(const _KeyT& key) const {
+		return contains(key);
+	}
+
+	// Insert the element, or overwrite it if the key already exists
+	// Returns whether the key is new
+	// ( Like every insert, throws std::runtime_error if the shard is full and can't grow, see _Check_Emplace )
+	template<typename _KeyArg, typename _TE>
+	SSTD_INLINE bool insert(_KeyArg&& key, _TE&& elt) {
+		const sizet hash = _Hash_Key(key);
+		_Shard& shard = _Get_Shard(hash);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		return _Check_Emplace(shard, shard.map._Insert_Or_Assign_Hash(_Shard_Hash(shard, key, hash), std::forward<_KeyArg>(key), std::forward<_TE>(elt))).second;
+	}
+
+	template<typename _KeyArg, typename _TE>
+	SSTD_INLINE bool insert_or_assign(_KeyArg&& key, _TE&& elt) {
+		return insert(std::forward<_KeyArg>(key), std::forward<_TE>(elt));
+	}
+
+	// Construct the element in place, only if the key doesn't exist yet
+	// Returns whether it got inserted
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE bool try_emplace(_KeyArg&& key, _Args&& ...args) {
+		const sizet hash = _Hash_Key(key);
+		_Shard& shard = _Get_Shard(hash);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		return _Check_Emplace(shard, shard.map._Try_Emplace_Hash(_Shard_Hash(shard, key, hash), std::forward<_KeyArg>(key), std::forward<_Args>(args)...)).second;
+	}
+
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE bool emplace(_KeyArg&& key, _Args&& ...args) {
+		return try_emplace(std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+	}
+
+	// Returns whether the key existed
+	SSTD_INLINE bool erase(const _KeyT& key) {
+		const sizet hash = _Hash_Key(key);
+		_Shard& shard = _Get_Shard(hash);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		return shard.map._Erase_Index(shard.map._Find_Index(key, _Shard_Hash(shard, key, hash)));
+	}
+
+	// Read-modify-write a single element atomically
+	// If the key doesn't exist, the element is constructed from args first
+	// Then fn(elt) is called, while the shard is still locked
+	// Returns whether the key is new
+	template<typename _Fn, typename ... _Args>
+	SSTD_INLINE bool upsert(const _KeyT& key, _Fn&& fn, _Args&& ...args) {
+		const sizet hash = _Hash_Key(key);
+		_Shard& shard = _Get_Shard(hash);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		const std::pair<typename map_type::iterator, bool> res = _Check_Emplace(shard, shard.map._Try_Emplace_Hash(_Shard_Hash(shard, key, hash), key, std::forward<_Args>(args)...));
+		fn(shard.map._Elt_At(map_type::_Index_Of(res.first)));
+		return res.second;
+	}
+
+	// Call fn(key, elt) on every element
+	// All the shards are locked for the whole walk, so fn sees one consistent snapshot of the map
+	template<typename _Fn>
+	SSTD_INLINE void for_each(_Fn&& fn) const {
+		_Lock_All<true> lock(this);
+		for (sizet s = 0; s < _Shards; ++s) {
+			const map_type& map = m_shards[s].map;
+			for (sizet i = 0; i < map.m_capacity; ++i) {
+				if (_Is_Full(map.m_ctrl[i])) {
+					fn(static_cast<const _KeyT&>(map.m_slots.Key(i)), static_cast<const _EltT&>(map.m_slots.Elt(i)));
+				}
+			}
+		}
+	}
+	// This version can modify the elements
+	template<typename _Fn>
+	SSTD_INLINE void for_each(_Fn&& fn) {
+		_Lock_All<false> lock(this);
+		for (sizet s = 0; s < _Shards; ++s) {
+			map_type& map = m_shards[s].map;
+			for (sizet i = 0; i < map.m_capacity; ++i) {
+				if (_Is_Full(map.m_ctrl[i])) {
+					fn(static_cast<const _KeyT&>(map.m_slots.Key(i)), map.m_slots.Elt(i));
+				}
+			}
+		}
+	}
+
+	// A consistent size ( all the shards are locked while counting )
+	SSTD_INLINE sizet size() const {
+		_Lock_All<true> lock(this);
+		sizet res = 0;
+		for (sizet s = 0; s < _Shards; ++s) {
+			res += m_shards[s].map.size();
+		}
+		return res;
+	}
+
+	SSTD_INLINE bool empty() const {
+		return size() == 0;
+	}
+
+	SSTD_INLINE void clear() {
+		_Lock_All<false> lock(this);
+		for (sizet s = 0; s < _Shards; ++s) {
+			m_shards[s].map.clear();
+		}
+	}
+
+	// Reserve _size slots in total ( spread across the shards )
+	SSTD_INLINE void reserve(const sizet& _size) {
+		for (sizet s = 0; s < _Shards; ++s) {
+			std::unique_lock<std::shared_mutex> lock(m_shards[s].mutex);
+			m_shards[s].map.reserve(_size / _Shards + 1);
+		}
+	}
+private:
+	_Shard m_shards[_Shards];
+
+	const _Hash m_Hasher{};
+	const uint64 m_seed = _Random_Seed();
+
+	// Locks every shard ( always in the same order, so two of these never deadlock )
+	template<bool _Shared>
+	struct _Lock_All {
+		const concurrent_unordered_map* map;
+
+		_Lock_All(const concurrent_unordered_map* _map) : map(_map) {
+			for (sizet s = 0; s < _Shards; ++s) {
+				if (_Shared) {
+					map->m_shards[s].mutex.lock_shared();
+				}
+				else {
+					map->m_shards[s].mutex.lock();
+				}
+			}
+		}
+		~_Lock_All() {
+			for (sizet s = _Shards; s-- > 0;) {
+				if (_Shared) {
+					map->m_shards[s].mutex.unlock_shared();
+				}
+				else {
+					map->m_shards[s].mutex.unlock();
+				}
+			}
+		}
+	};
+
+	// An emplace on a shard that is full ( and couldn't grow ) hands back the end of the shard, which has no element
+	// Nothing got inserted then, so throw instead of letting anyone touch it
+	template<typename _Res>
+	static SSTD_INLINE const _Res& _Check_Emplace(const _Shard& shard, const _Res& res) {
+		if (map_type::_Index_Of(res.first) == shard.map.m_capacity) {
+			throw std::runtime_error("Concurrent unordered map shard is full");
+		}
+		return res;
+	}
+
+	// Same hash as the shards use, so it's only computed once
+	template<typename _KeyLike>
+	SSTD_INLINE sizet _Hash_Key(const _KeyLike& key) const {
+		return _Table_Hash(m_Hasher, key, m_seed);
+	}
+
+	// The shards start out with the seed of the whole map, so the hash that picked the shard gets reused inside of it
+	SSTD_INLINE void _Share_Seed() noexcept {
+		for (sizet s = 0; s < _Shards; ++s) {
+			m_shards[s].map.m_seed = m_seed;
+		}
+	}
+	// But a shard can reseed itself ( see unordered_map::_Probe_Alarm ), then it needs its own hash
+	// ( The shard of a key never changes, it's always picked with m_seed )
+	template<typename _KeyLike>
+	SSTD_INLINE sizet _Shard_Hash(const _Shard& shard, const _KeyLike& key, const sizet& hash) const {
+		return shard.map.m_seed == m_seed ? hash : shard.map._Hash_Key(key);
+	}
+
+	// The 16 bits right below the control byte bits pick the shard,
+	// the shards still probe with the low bits and filter with the top 7 bits
+	SSTD_INLINE _Shard& _Get_Shard(const sizet& hash) noexcept {
+		return m_shards[(hash >> (sizeof(sizet) * 8 - 7 - 16)) & (_Shards - 1)];
+	}
+	SSTD_INLINE const _Shard& _Get_Shard(const sizet& hash) const noexcept {
+		return m_shards[(hash >> (sizeof(sizet) * 8 - 7 - 16)) & (_Shards - 1)];
+	}
+};
+
+SSTD_END
+
+#endif
@@ -4,6 +4,19 @@
 #include <iostream>
 #include <cassert>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SSTD_HAS_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define SSTD_HAS_AVX2
+#include <immintrin.h>
+#endif
+
 #define SSTD_BEGIN namespace sstd {
 #define SSTD_END	}
 
@@ -17,6 +30,13 @@
 
 #define SSTD_ASSERT assert
 
+// Hint the cpu to start loading the cache line of ptr
+#if defined(_MSC_VER)
+#define SSTD_PREFETCH(ptr) _mm_prefetch(reinterpret_cast<const char*>(ptr), _MM_HINT_T0)
+#else
+#define SSTD_PREFETCH(ptr) __builtin_prefetch(ptr)
+#endif
+
 SSTD_BEGIN
 
 using int8 = std::int8_t;
@@ -33,6 +53,26 @@ using sizet = std::size_t;
 
 using Decimal = double;
 
+// Index of the lowest set bit ( x can't be 0 )
+SSTD_INLINE uint32 _Count_Trailing_Zeros(uint32 x) noexcept {
+#if defined(_MSC_VER)
+	unsigned long ind;
+	_BitScanForward(&ind, x);
+	return static_cast<uint32>(ind);
+#else
+	return static_cast<uint32>(__builtin_ctz(x));
+#endif
+}
+
+// Amount of set bits
+SSTD_INLINE uint32 _Pop_Count(uint32 x) noexcept {
+#if defined(_MSC_VER)
+	return static_cast<uint32>(__popcnt(x));
+#else
+	return static_cast<uint32>(__builtin_popcount(x));
+#endif
+}
+
 SSTD_END
 
 #endif
\ No newline at end of file
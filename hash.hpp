@@ -0,0 +1,421 @@
+#ifndef SSTD_HASH_INCLUDED
+#define SSTD_HASH_INCLUDED
+
+#include "core.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+SSTD_BEGIN
+
+// Hash functions for the hash tables
+//
+// Byte strings use a wyhash style hash ( 128 bit multiply + fold ),
+// long ones switch to a xxh3 style accumulator that runs on SSE2 / AVX2 if available
+// ( every path gives the exact same result, so hashes don't change between builds )
+// Integers go through two rounds of 128 bit multiply + fold
+// Pairs and tuples combine the hashes of their members
+//
+// Every sstd::hash avalanches ( every input bit affects every output bit ),
+// so the tables use them as they are, instead of mixing them once more
+//
+// Every sstd::hash also takes an optional seed
+// The tables pick a random seed per instance, so nobody can craft keys that collide on purpose
+// ( That only works if the hash of the key type itself doesn't collide, std::hash fallbacks can )
+
+// -----------------------------------------
+//
+//   Building blocks
+//
+// -----------------------------------------
+
+SSTD_CONSTEXPR uint64 _Wy_P0 = 0xa0761d6478bd642full;
+SSTD_CONSTEXPR uint64 _Wy_P1 = 0xe7037ed1a0b428dbull;
+SSTD_CONSTEXPR uint64 _Wy_P2 = 0x8ebc6af09c88c6e3ull;
+SSTD_CONSTEXPR uint64 _Wy_P3 = 0x589965cc75374cc3ull;
+
+// Full 128 bit product of a and b, the low half goes to a, the high half to b
+SSTD_INLINE void _Mum(uint64& a, uint64& b) noexcept {
+#if defined(__SIZEOF_INT128__)
+	__uint128_t res = a;
+	res *= b;
+	a = static_cast<uint64>(res);
+	b = static_cast<uint64>(res >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	a = _umul128(a, b, &b);
+#else
+	const uint64 ha = a >> 32, hb = b >> 32, la = static_cast<uint32>(a), lb = static_cast<uint32>(b);
+	const uint64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	const uint64 t = rl + (rm0 << 32);
+	uint64 c = t < rl;
+	const uint64 lo = t + (rm1 << 32);
+	c += lo < t;
+	a = lo;
+	b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+// Multiply and fold the two halves together
+SSTD_INLINE uint64 _Wy_Mix(uint64 a, uint64 b) noexcept {
+	_Mum(a, b);
+	return a ^ b;
+}
+
+SSTD_INLINE uint64 _Read_64(const uint8* p) noexcept {
+	uint64 res;
+	std::memcpy(&res, p, sizeof(res));
+	return res;
+}
+SSTD_INLINE uint64 _Read_32(const uint8* p) noexcept {
+	uint32 res;
+	std::memcpy(&res, p, sizeof(res));
+	return res;
+}
+// 1 to 3 bytes
+SSTD_INLINE uint64 _Read_Small(const uint8* p, const sizet& len) noexcept {
+	return (static_cast<uint64>(p[0]) << 16) | (static_cast<uint64>(p[len >> 1]) << 8) | p[len - 1];
+}
+
+// -----------------------------------------
+//
+//   Byte strings
+//
+// -----------------------------------------
+
+// Inputs this long go through the accumulator
+SSTD_CONSTEXPR sizet _Long_Hash_Bytes = 512;
+
+// Stripes between two scrambles of the accumulator
+SSTD_CONSTEXPR sizet _Hash_Block_Stripes = 16;
+
+// Mixed into the accumulator, moves by one lane every stripe
+// Every stripe of a block gets its own offset, otherwise two stripes with the same one add up the same way,
+// and the same change in either of them gives the same hash
+alignas(64) SSTD_CONSTEXPR uint64 _Hash_Secret[_Hash_Block_Stripes + 8] = {
+	0xc0e16b163a85a4dcull, 0x890acd8dd443c47cull, 0xb3889d8a6dc47761ull, 0x6a0398e528f0ae6aull,
+	0x048344ece48a855eull, 0xf175cfea21871330ull, 0x391ceef02702c2fdull, 0x4baf8cac4784cb12ull,
+	0x3547744583a3f88eull, 0xd9cf2b15c6b6c90eull, 0x961facc76d5fe21cull, 0x0094ab49d50f11f9ull,
+	0xe3211e37bdbeb6dcull, 0x62fe6c274ff3511aull, 0x5ac30b329fdf0574ull, 0x1450582c6b65b406ull,
+	0xba6dd33e22266a0bull, 0x83c9e5db8f89697full, 0xae5b7a7da9f7e03cull, 0x8c39d2ee690383a8ull,
+	0x71ad04cf4be4be01ull, 0x1939b0172c97bfa5ull, 0x96256bbeb51f55bfull, 0xd94d7fdcf41c2ed8ull,
+};
+
+// wyhash, for anything shorter than _Long_Hash_Bytes
+SSTD_INLINE uint64 _Hash_Short(const uint8* p, const sizet& len, uint64 seed) noexcept {
+	seed ^= _Wy_Mix(seed ^ _Wy_P0, _Wy_P1);
+	uint64 a, b;
+	if (len <= 16) {
+		if (len >= 4) {
+			const sizet mid = (len >> 3) << 2;
+			a = (_Read_32(p) << 32) | _Read_32(p + mid);
+			b = (_Read_32(p + len - 4) << 32) | _Read_32(p + len - 4 - mid);
+		}
+		else if (len > 0) {
+			a = _Read_Small(p, len);
+			b = 0;
+		}
+		else {
+			a = b = 0;
+		}
+	}
+	else {
+		sizet i = len;
+		if (i > 48) {
+			uint64 see1 = seed, see2 = seed;
+			do {
+				seed = _Wy_Mix(_Read_64(p) ^ _Wy_P1, _Read_64(p + 8) ^ seed);
+				see1 = _Wy_Mix(_Read_64(p + 16) ^ _Wy_P2, _Read_64(p + 24) ^ see1);
+				see2 = _Wy_Mix(_Read_64(p + 32) ^ _Wy_P3, _Read_64(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = _Wy_Mix(_Read_64(p) ^ _Wy_P1, _Read_64(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = _Read_64(p + i - 16);
+		b = _Read_64(p + i - 8);
+	}
+	a ^= _Wy_P1;
+	b ^= seed;
+	_Mum(a, b);
+	return _Wy_Mix(a ^ _Wy_P0 ^ len, b ^ _Wy_P1);
+}
+
+#if defined(SSTD_HAS_AVX2)
+// One register of lanes ( see _Accumulate_Stripes )
+SSTD_INLINE __m256i _Accumulate_Lanes(const __m256i& lanes, const uint8* p, const uint64* secret) noexcept {
+	const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+	const __m256i key = _mm256_xor_si256(data, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret)));
+	const __m256i product = _mm256_mul_epu32(key, _mm256_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+	const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+	return _mm256_add_epi64(lanes, _mm256_add_epi64(product, swapped));
+}
+#elif defined(SSTD_HAS_SSE2)
+SSTD_INLINE __m128i _Accumulate_Lanes(const __m128i& lanes, const uint8* p, const uint64* secret) noexcept {
+	const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	const __m128i key = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret)));
+	const __m128i product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+	const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+	return _mm_add_epi64(lanes, _mm_add_epi64(product, swapped));
+}
+#endif
+
+// count 64 byte stripes into the 8 accumulator lanes ( xxh3 style ), the first one being stripe number first
+// Every lane gets the 32 x 32 bit product of its two halves ( after mixing in the secret ),
+// plus the raw input of its neighbour lane, so no input bit can get lost in a product
+// The secret moves by one lane every stripe
+SSTD_INLINE void _Accumulate_Stripes(uint64* acc, const uint8* p, const sizet& first, const sizet& count) noexcept {
+#if defined(SSTD_HAS_AVX2)
+	__m256i lanes0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc));
+	__m256i lanes1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + 4));
+	for (sizet n = first; n != first + count; ++n, p += 64) {
+		const uint64* secret = _Hash_Secret + (n & (_Hash_Block_Stripes - 1));
+		lanes0 = _Accumulate_Lanes(lanes0, p, secret);
+		lanes1 = _Accumulate_Lanes(lanes1, p + 32, secret + 4);
+	}
+	_mm256_store_si256(reinterpret_cast<__m256i*>(acc), lanes0);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(acc + 4), lanes1);
+#elif defined(SSTD_HAS_SSE2)
+	__m128i lanes0 = _mm_load_si128(reinterpret_cast<const __m128i*>(acc));
+	__m128i lanes1 = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + 2));
+	__m128i lanes2 = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + 4));
+	__m128i lanes3 = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + 6));
+	for (sizet n = first; n != first + count; ++n, p += 64) {
+		const uint64* secret = _Hash_Secret + (n & (_Hash_Block_Stripes - 1));
+		lanes0 = _Accumulate_Lanes(lanes0, p, secret);
+		lanes1 = _Accumulate_Lanes(lanes1, p + 16, secret + 2);
+		lanes2 = _Accumulate_Lanes(lanes2, p + 32, secret + 4);
+		lanes3 = _Accumulate_Lanes(lanes3, p + 48, secret + 6);
+	}
+	_mm_store_si128(reinterpret_cast<__m128i*>(acc), lanes0);
+	_mm_store_si128(reinterpret_cast<__m128i*>(acc + 2), lanes1);
+	_mm_store_si128(reinterpret_cast<__m128i*>(acc + 4), lanes2);
+	_mm_store_si128(reinterpret_cast<__m128i*>(acc + 6), lanes3);
+#else
+	for (sizet n = first; n != first + count; ++n, p += 64) {
+		const uint64* secret = _Hash_Secret + (n & (_Hash_Block_Stripes - 1));
+		for (sizet i = 0; i < 8; ++i) {
+			const uint64 data = _Read_64(p + i * 8);
+			const uint64 key = data ^ secret[i];
+			acc[i ^ 1] += data;
+			acc[i] += (key & 0xFFFFFFFFull) * (key >> 32);
+		}
+	}
+#endif
+}
+
+// Every block of stripes, so the high bits of the lanes flow back down
+SSTD_INLINE void _Scramble_Accumulator(uint64* acc) noexcept {
+	for (sizet i = 0; i < 8; ++i) {
+		acc[i] ^= acc[i] >> 47;
+		acc[i] ^= _Hash_Secret[i];
+		acc[i] *= 0x9E3779B1ull;
+	}
+}
+
+SSTD_INLINE uint64 _Hash_Long(const uint8* p, const sizet& len, const uint64& seed) noexcept {
+	alignas(32) uint64 acc[8];
+	for (sizet i = 0; i < 8; ++i) {
+		acc[i] = _Hash_Secret[i + 8] ^ seed;
+	}
+	const sizet stripes = len / 64;
+	sizet n = 0;
+	for (; n + _Hash_Block_Stripes <= stripes; n += _Hash_Block_Stripes) {
+		_Accumulate_Stripes(acc, p + n * 64, n, _Hash_Block_Stripes);
+		_Scramble_Accumulator(acc);
+	}
+	_Accumulate_Stripes(acc, p + n * 64, n, stripes - n);
+	uint64 res = seed ^ (len * _Wy_P0);
+	res = _Wy_Mix(acc[0] ^ _Wy_P0, acc[1] ^ res);
+	res = _Wy_Mix(acc[2] ^ _Wy_P1, acc[3] ^ res);
+	res = _Wy_Mix(acc[4] ^ _Wy_P2, acc[5] ^ res);
+	res = _Wy_Mix(acc[6] ^ _Wy_P3, acc[7] ^ res);
+	// The last ( partial ) stripe
+	return _Hash_Short(p + stripes * 64, len & 63, res);
+}
+
+// Hash len bytes starting at data
+SSTD_INLINE uint64 hash_bytes(const void* data, const sizet& len, const uint64& seed = 0) noexcept {
+	const uint8* p = static_cast<const uint8*>(data);
+	if (len >= _Long_Hash_Bytes) {
+		return _Hash_Long(p, len, seed);
+	}
+	return _Hash_Short(p, len, seed);
+}
+
+// -----------------------------------------
+//
+//   Integers and combining
+//
+// -----------------------------------------
+
+// A 128 bit multiply by 2^64 / golden ratio, with the halves folded together, then a second multiply + fold
+// A single one leaves the low bits of sequential keys clumped ( the tables pick the slot with those ),
+// and flips every output bit with a probability of only about 0.48 ( see tests/hash.cpp )
+SSTD_INLINE uint64 _Hash_Int(const uint64& x, const uint64& seed = 0) noexcept {
+	return _Wy_Mix(_Wy_Mix(x ^ seed, 0x9E3779B97F4A7C15ull) ^ _Wy_P0, _Wy_P1);
+}
+
+// Hash of value, mixed into seed ( for hashing several values as one )
+SSTD_INLINE sizet hash_combine(const sizet& seed, const sizet& value) noexcept {
+	return static_cast<sizet>(_Wy_Mix(static_cast<uint64>(seed) ^ _Wy_P0, static_cast<uint64>(value) ^ _Wy_P1));
+}
+
+// -----------------------------------------
+//
+//   Hash functors
+//
+// -----------------------------------------
+
+// Integers, enums, pointers and floating points are hashed directly,
+// anything else goes through std::hash, and gets mixed afterwards
+template<typename T>
+struct hash {
+	using is_avalanching = void;
+
+	SSTD_INLINE sizet operator()(const T& key, const uint64& seed = 0) const noexcept(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value) {
+		if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+			return static_cast<sizet>(_Hash_Int(static_cast<uint64>(key), seed));
+		}
+		else if constexpr (std::is_pointer<T>::value) {
+			return static_cast<sizet>(_Hash_Int(static_cast<uint64>(reinterpret_cast<std::uintptr_t>(key)), seed));
+		}
+		else if constexpr (std::is_same<T, float>::value || std::is_same<T, double>::value) {
+			// 0.0 and -0.0 are equal, so they need the same hash
+			if (key == 0) {
+				return static_cast<sizet>(_Hash_Int(0, seed));
+			}
+			std::conditional_t<sizeof(T) == 4, uint32, uint64> bits;
+			std::memcpy(&bits, &key, sizeof(bits));
+			return static_cast<sizet>(_Hash_Int(bits, seed));
+		}
+		else {
+			return static_cast<sizet>(_Hash_Int(static_cast<uint64>(std::hash<T>()(key)), seed));
+		}
+	}
+};
+
+// A hash functor that defines is_transparent can hash types other than the key type
+// unordered_map::find / contains / count / at then accept those types directly ( no temporary key needed )
+// The key-like type must hash the same as the equal key, and be comparable to the key with ==
+template<>
+struct hash<std::string> {
+	using is_transparent = void;
+	using is_avalanching = void;
+
+	SSTD_INLINE sizet operator()(const std::string_view key, const uint64& seed = 0) const noexcept {
+		return static_cast<sizet>(hash_bytes(key.data(), key.size(), seed));
+	}
+};
+template<>
+struct hash<std::string_view> : hash<std::string> {};
+
+template<typename _First, typename _Second>
+struct hash<std::pair<_First, _Second> > {
+	using is_avalanching = void;
+
+	SSTD_INLINE sizet operator()(const std::pair<_First, _Second>& key, const uint64& seed = 0) const {
+		return hash_combine(hash<_First>()(key.first, seed), hash<_Second>()(key.second, seed));
+	}
+};
+
+template<typename ... _Types>
+struct hash<std::tuple<_Types...> > {
+	using is_avalanching = void;
+
+	SSTD_INLINE sizet operator()(const std::tuple<_Types...>& key, const uint64& seed = 0) const {
+		return _Combine(key, seed, std::index_sequence_for<_Types...>());
+	}
+private:
+	template<sizet ... _Inds>
+	SSTD_INLINE static sizet _Combine(const std::tuple<_Types...>& key, const uint64& seed, std::index_sequence<_Inds...>) {
+		sizet res = sizeof...(_Types);
+		((res = hash_combine(res, hash<std::tuple_element_t<_Inds, std::tuple<_Types...> > >()(std::get<_Inds>(key), seed))), ...);
+		return res;
+	}
+};
+
+// -----------------------------------------
+//
+//   Hash functor traits
+//
+// -----------------------------------------
+
+template<typename _Hash, typename = void>
+struct _Is_Transparent : std::false_type {};
+template<typename _Hash>
+struct _Is_Transparent<_Hash, std::void_t<typename _Hash::is_transparent> > : std::true_type {};
+
+// A hash functor that defines is_avalanching promises its hashes are already well mixed
+template<typename _Hash, typename = void>
+struct _Is_Avalanching : std::false_type {};
+template<typename _Hash>
+struct _Is_Avalanching<_Hash, std::void_t<typename _Hash::is_avalanching> > : std::true_type {};
+
+// A hash functor that can be called as hash(key, seed)
+template<typename _Hash, typename _KeyLike, typename = void>
+struct _Is_Seeded : std::false_type {};
+template<typename _Hash, typename _KeyLike>
+struct _Is_Seeded<_Hash, _KeyLike, std::void_t<decltype(std::declval<const _Hash&>()(std::declval<const _KeyLike&>(), uint64()))> > : std::true_type {};
+
+// A fresh seed for every table
+// One random number per process ( std::random_device can be slow ), stepped by a counter and mixed
+SSTD_INLINE uint64 _Random_Seed() noexcept {
+	static const uint64 base = [] {
+		uint64 res = static_cast<uint64>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+		try {
+			std::random_device device;
+			res ^= (static_cast<uint64>(device()) << 32) ^ device();
+		}
+		catch (...) {
+			// No random device, the clock has to do
+		}
+		return res;
+	}();
+	static std::atomic<uint64> counter{ 0 };
+	return _Wy_Mix(base ^ _Wy_P0, counter.fetch_add(1, std::memory_order_relaxed) ^ _Wy_P1);
+}
+
+// Other hashes only get mixed once more before they are used ( fibonacci hashing style ),
+// with the seed mixed in first
+// Multiply by 2^64 / golden ratio, and fold the high bits back down
+// The low bits pick the slot and the top 7 bits are the control byte, so both ends need to be mixed well
+// ( Identity-like hashes such as std::hash for integers would cluster really badly otherwise )
+SSTD_INLINE SSTD_CONSTEXPR sizet _Mix_Hash(sizet hash) noexcept {
+	hash ^= hash >> (sizeof(sizet) * 4);
+	hash *= static_cast<sizet>(0x9E3779B97F4A7C15ull);
+	return hash ^ (hash >> 29);
+}
+
+// The hash the tables actually use for key
+template<typename _Hash, typename _KeyLike>
+SSTD_INLINE sizet _Table_Hash(const _Hash& hasher, const _KeyLike& key, const uint64& seed) {
+	if constexpr (_Is_Seeded<_Hash, _KeyLike>::value) {
+		if constexpr (_Is_Avalanching<_Hash>::value) {
+			return hasher(key, seed);
+		}
+		else {
+			return _Mix_Hash(hasher(key, seed));
+		}
+	}
+	else {
+		return _Mix_Hash(hasher(key) ^ static_cast<sizet>(seed));
+	}
+}
+
+SSTD_END
+
+#endif
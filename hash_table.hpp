@@ -0,0 +1,1664 @@
+#ifndef SSTD_HASH_TABLE_INCLUDED
+#define SSTD_HASH_TABLE_INCLUDED
+
+#include "core.hpp"
+#include "allocator.hpp"
+#include "hash.hpp"
+#include "relocate.hpp"
+#ifdef SSTD_HASH_TABLE_STATS
+// Only the rehash timing of stats() needs the clock
+#include "Debug/Time.hpp"
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+SSTD_BEGIN
+
+// Smallest power of 2 that is >= n
+SSTD_INLINE SSTD_CONSTEXPR sizet _Round_Up_Power_Of_2(sizet n) noexcept {
+	sizet res = 1;
+	while (res < n) {
+		res <<= 1;
+	}
+	return res;
+}
+
+// n rounded up to a multiple of align ( a power of 2 )
+SSTD_INLINE SSTD_CONSTEXPR sizet _Align_Up(const sizet& n, const sizet& align) noexcept {
+	return (n + align - 1) & ~(align - 1);
+}
+
+// Write count zero bytes
+SSTD_INLINE bool _Write_Padding(std::FILE* file, sizet count) {
+	static const unsigned char zeros[64] = {};
+	while (count) {
+		const sizet chunk = count < sizeof(zeros) ? count : sizeof(zeros);
+		if (std::fwrite(zeros, 1, chunk, file) != chunk) {
+			return false;
+		}
+		count -= chunk;
+	}
+	return true;
+}
+
+// -----------------------------------------
+//
+//   Control bytes
+//
+// -----------------------------------------
+
+// Every slot owns one control byte, stored in a separate array from the slots
+// Empty and deleted slots are negative, a full slot stores the top 7 bits of its hash
+// So probing only has to touch the ( small ) control array,
+// and the keys are only compared when the hash fragment matches
+
+using _Ctrl_T = int8;
+
+SSTD_CONSTEXPR _Ctrl_T _Ctrl_Empty = -128;
+SSTD_CONSTEXPR _Ctrl_T _Ctrl_Deleted = -2;
+
+SSTD_INLINE SSTD_CONSTEXPR _Ctrl_T _Hash_Fragment(const sizet hash) noexcept {
+	return static_cast<_Ctrl_T>(hash >> (sizeof(sizet) * 8 - 7));
+}
+SSTD_INLINE SSTD_CONSTEXPR bool _Is_Full(const _Ctrl_T ctrl) noexcept {
+	return ctrl >= 0;
+}
+
+// Scans _Width control bytes at once
+// Each function returns a bitmask, bit n is set if the nth byte of the group matches
+template<sizet _Width>
+struct _Ctrl_Group {
+	static_assert(_Width <= 32, "The group bitmask only holds 32 control bytes");
+
+	static SSTD_INLINE uint32 Match(const _Ctrl_T* ctrl, const _Ctrl_T fragment) noexcept {
+		uint32 mask = 0;
+		for (sizet i = 0; i < _Width; ++i) {
+			mask |= static_cast<uint32>(ctrl[i] == fragment) << i;
+		}
+		return mask;
+	}
+	static SSTD_INLINE uint32 Match_Empty(const _Ctrl_T* ctrl) noexcept {
+		return Match(ctrl, _Ctrl_Empty);
+	}
+	static SSTD_INLINE uint32 Match_Empty_Or_Deleted(const _Ctrl_T* ctrl) noexcept {
+		uint32 mask = 0;
+		for (sizet i = 0; i < _Width; ++i) {
+			mask |= static_cast<uint32>(ctrl[i] < -1) << i;
+		}
+		return mask;
+	}
+	static SSTD_INLINE uint32 Match_Full(const _Ctrl_T* ctrl) noexcept {
+		uint32 mask = 0;
+		for (sizet i = 0; i < _Width; ++i) {
+			mask |= static_cast<uint32>(_Is_Full(ctrl[i])) << i;
+		}
+		return mask;
+	}
+};
+
+#ifdef SSTD_HAS_SSE2
+template<>
+struct _Ctrl_Group<16> {
+	static SSTD_INLINE uint32 Match(const _Ctrl_T* ctrl, const _Ctrl_T fragment) noexcept {
+		const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+		return static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(fragment))));
+	}
+	static SSTD_INLINE uint32 Match_Empty(const _Ctrl_T* ctrl) noexcept {
+		return Match(ctrl, _Ctrl_Empty);
+	}
+	static SSTD_INLINE uint32 Match_Empty_Or_Deleted(const _Ctrl_T* ctrl) noexcept {
+		const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+		return static_cast<uint32>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), group)));
+	}
+	// Full bytes are the only ones with the sign bit clear, so no compare is needed
+	static SSTD_INLINE uint32 Match_Full(const _Ctrl_T* ctrl) noexcept {
+		const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+		return static_cast<uint32>(_mm_movemask_epi8(group)) ^ 0xFFFFu;
+	}
+};
+#endif
+
+#ifdef SSTD_HAS_AVX2
+template<>
+struct _Ctrl_Group<32> {
+	static SSTD_INLINE uint32 Match(const _Ctrl_T* ctrl, const _Ctrl_T fragment) noexcept {
+		const __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ctrl));
+		return static_cast<uint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(group, _mm256_set1_epi8(fragment))));
+	}
+	static SSTD_INLINE uint32 Match_Empty(const _Ctrl_T* ctrl) noexcept {
+		return Match(ctrl, _Ctrl_Empty);
+	}
+	static SSTD_INLINE uint32 Match_Empty_Or_Deleted(const _Ctrl_T* ctrl) noexcept {
+		const __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ctrl));
+		return static_cast<uint32>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-1), group)));
+	}
+	static SSTD_INLINE uint32 Match_Full(const _Ctrl_T* ctrl) noexcept {
+		const __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ctrl));
+		return ~static_cast<uint32>(_mm256_movemask_epi8(group));
+	}
+};
+#endif
+
+// One probing step with a width of 1 is just a plain scalar check
+template<>
+struct _Ctrl_Group<1> {
+	static SSTD_INLINE uint32 Match(const _Ctrl_T* ctrl, const _Ctrl_T fragment) noexcept {
+		return *ctrl == fragment;
+	}
+	static SSTD_INLINE uint32 Match_Empty(const _Ctrl_T* ctrl) noexcept {
+		return *ctrl == _Ctrl_Empty;
+	}
+	static SSTD_INLINE uint32 Match_Empty_Or_Deleted(const _Ctrl_T* ctrl) noexcept {
+		return *ctrl < -1;
+	}
+	static SSTD_INLINE uint32 Match_Full(const _Ctrl_T* ctrl) noexcept {
+		return _Is_Full(*ctrl);
+	}
+};
+
+#ifdef SSTD_HAS_AVX2
+SSTD_CONSTEXPR sizet _Default_Group_Width = 32;
+#else
+SSTD_CONSTEXPR sizet _Default_Group_Width = 16;
+#endif
+
+// The first full slot at or after ind in a control array ( capacity if there is none )
+// Scans a whole group of control bytes per step, and jumps straight to the first full one with a bit scan
+// ( The last few bytes that don't fill a group are checked one at a time, so nothing past capacity is read )
+SSTD_INLINE sizet _Next_Full_In(const _Ctrl_T* ctrl, sizet ind, const sizet& capacity) noexcept {
+	using _Scan = _Ctrl_Group<_Default_Group_Width>;
+	for (; ind + _Default_Group_Width <= capacity; ind += _Default_Group_Width) {
+		const uint32 full = _Scan::Match_Full(ctrl + ind);
+		if (full) {
+			return ind + _Count_Trailing_Zeros(full);
+		}
+	}
+	while (ind < capacity && !_Is_Full(ctrl[ind])) {
+		++ind;
+	}
+	return ind;
+}
+
+// -----------------------------------------
+//
+//   probing functors
+//
+// -----------------------------------------
+
+// The probing functors get the ( cached ) hash of the key instead of the key itself,
+// so walking the probing sequence never calls the hash function again
+//
+// The capacity is always a power of 2, so the functors get capacity - 1 as a mask instead of doing a ( slow ) modulo
+//
+// The group_width of a probing functor is how many slots one probing step covers
+// Scalar probing functors check a single slot every step
+// max_load_factor is the load factor the table is kept under
+// robin_hood selects the robin hood insertion / backward shift deletion ( see _Robin_Hood_Prob )
+// An insert that needs more probing steps than max_probe_length triggers the watchdog ( see _Hash_Table::_Probe_Alarm )
+struct _Scalar_Prob {
+	static SSTD_CONSTEXPR sizet group_width = 1;
+	static SSTD_CONSTEXPR Decimal max_load_factor = 0.5;
+	static SSTD_CONSTEXPR bool robin_hood = false;
+	static SSTD_CONSTEXPR sizet max_probe_length = 128;
+};
+
+template<typename T, typename _Hash>
+struct _Linear_Prob : _Scalar_Prob {
+	SSTD_INLINE sizet operator()(const sizet& hash, const sizet& i, const sizet& mask) const {
+		return (hash + i) & mask;
+	}
+};
+template<typename T, int32 c1, int32 c2, typename _Hash>
+struct _Quadratic_Prob1 : _Scalar_Prob {
+	SSTD_INLINE sizet operator()(const sizet& hash, const sizet& i, const sizet& mask) const {
+		return (hash + c1 * i + c2 * i * i) & mask;
+	}
+};
+// Triangular numbers ( 0, 1, 3, 6, 10 ... ) visit every slot of a power of 2 table exactly once
+template<typename T, int32 c1, int32 c2, typename _Hash>
+struct _Quadratic_Prob2 : _Scalar_Prob {
+	SSTD_INLINE sizet operator()(const sizet& hash, const sizet& i, const sizet& mask) const {
+		return (hash + i * (i + 1) / 2) & mask;
+	}
+};
+template<typename T, typename _Hash>
+struct _Double_Hash_Prob : _Scalar_Prob {
+	SSTD_INLINE sizet operator()(const sizet& hash, const sizet& i, const sizet& mask) const {
+		return (hash + // First hash
+			i * ( (hash >> (sizeof(sizet) * 4)) // i * second hash ( the high bits, the low bits are the first hash )
+				| 0x0000000000000001 // Add this to make the second hash result an odd number, which visits every slot
+			) 
+		) & mask;
+	}
+};
+
+// Swiss table style probing
+// Every probing step covers a whole group of _Width slots, which are scanned with one SIMD compare
+// The groups are visited in triangular steps, and the first slot of the group is returned
+// ( The capacity is always a multiple of _Width when this is used )
+template<typename T, typename _Hash, sizet _Width = _Default_Group_Width>
+struct _Group_Prob {
+	static SSTD_CONSTEXPR sizet group_width = _Width;
+	// A group is only skipped when all of its slots are full, so it handles a high load just fine
+	static SSTD_CONSTEXPR Decimal max_load_factor = 0.875;
+	static SSTD_CONSTEXPR bool robin_hood = false;
+	// In groups, a table with millions of elements close to max_load_factor gets to about 20 of them on its own
+	static SSTD_CONSTEXPR sizet max_probe_length = 32;
+
+	SSTD_INLINE sizet operator()(const sizet& hash, const sizet& i, const sizet& mask) const {
+		return ((hash + i * (i + 1) / 2) & (mask / _Width)) * _Width;
+	}
+};
+
+// Robin hood hashing ( on top of linear probing )
+// An insert takes the slot of any element that is closer to its home slot than the new element is,
+// so the probing lengths stay about the same for every element even with a high load
+// A lookup can stop as soon as it meets an element closer to its home than the key would be,
+// and an erase shifts the following elements back instead of leaving a deleted slot
+template<typename T, typename _Hash>
+struct _Robin_Hood_Prob : _Scalar_Prob {
+	static SSTD_CONSTEXPR Decimal max_load_factor = 0.875;
+	static SSTD_CONSTEXPR bool robin_hood = true;
+
+	SSTD_INLINE sizet operator()(const sizet& hash, const sizet& i, const sizet& mask) const {
+		return (hash + i) & mask;
+	}
+
+	// How far away the slot ind is from the home slot of hash
+	SSTD_INLINE sizet distance(const sizet& hash, const sizet& ind, const sizet& mask) const {
+		return (ind - hash) & mask;
+	}
+};
+
+
+// -----------------------------------------
+//
+//   Table storage
+//
+// -----------------------------------------
+
+// The full hash is cached next to the key,
+// so rehashing and probing never need to call the hash function again
+template<typename _KeyT, typename _EltT>
+struct _Map_Element {
+	_KeyT key;
+	_EltT elt;
+	sizet hash;
+};
+
+// Storage policies decide how the slots are laid out in memory
+// The map only talks to them through the functions below, and tracks which slots are full itself ( control bytes )
+// Allocate / Deallocate only get / free the raw slot memory ( from the allocator of the table ), Construct / Destroy handle a single full slot
+// Release frees whatever else the storage owns, once the map is done with it ( destructor / clear )
+// Flat storages keep everything in the slot memory, so it can be written out and mapped back in ( see unordered_map::save )
+// Trivially destructible storages have nothing to Destroy, so clear doesn't walk the table for it
+
+// Key, element and hash side by side in one array
+// A hit costs a single cache miss, but probing drags the elements through the cache as well
+template<typename _KeyT, typename _EltT>
+struct _Inline_Storage {
+	using _Map_Element = sstd::_Map_Element<_KeyT, _EltT>;
+
+	static SSTD_CONSTEXPR bool flat = true;
+	static SSTD_CONSTEXPR bool trivially_destructible = std::is_trivially_destructible<_KeyT>::value && std::is_trivially_destructible<_EltT>::value;
+
+	_Map_Element* table = nullptr;
+
+	template<typename _AllocT>
+	SSTD_INLINE void Allocate(const sizet& capacity, _AllocT& alloc) {
+		table = static_cast<_Map_Element*>(alloc.allocate(sizeof(_Map_Element) * capacity));
+	}
+	template<typename _AllocT>
+	SSTD_INLINE void Deallocate(const sizet& capacity, _AllocT& alloc) noexcept {
+		if (table) {
+			alloc.deallocate(table, sizeof(_Map_Element) * capacity);
+		}
+		table = nullptr;
+	}
+	template<typename _AllocT>
+	SSTD_INLINE void Release(_AllocT&) noexcept {}
+
+	SSTD_INLINE _KeyT& Key(const sizet& ind) const noexcept {
+		return table[ind].key;
+	}
+	SSTD_INLINE _EltT& Elt(const sizet& ind) const noexcept {
+		return table[ind].elt;
+	}
+	SSTD_INLINE sizet Hash(const sizet& ind) const noexcept {
+		return table[ind].hash;
+	}
+	SSTD_INLINE void Set_Hash(const sizet& ind, const sizet& hash) noexcept {
+		table[ind].hash = hash;
+	}
+	// What a lookup reads first ( for prefetching )
+	SSTD_INLINE const void* Probe_Address(const sizet& ind) const noexcept {
+		return table + ind;
+	}
+
+	// The slot memory as one block of bytes
+	SSTD_INLINE static SSTD_CONSTEXPR sizet Bytes(const sizet& capacity) noexcept {
+		return sizeof(_Map_Element) * capacity;
+	}
+	SSTD_INLINE bool Write(std::FILE* file, const sizet& capacity) const {
+		return std::fwrite(table, sizeof(_Map_Element), capacity, file) == capacity;
+	}
+	// Use memory ( Bytes(capacity) of them, 64 byte aligned ) as the slots, without owning it
+	SSTD_INLINE void Attach(unsigned char* memory, const sizet&) noexcept {
+		table = reinterpret_cast<_Map_Element*>(memory);
+	}
+
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE void Construct(const sizet& ind, const sizet& hash, _KeyArg&& key, _Args&& ...args) {
+		new (&table[ind].key) _KeyT(std::forward<_KeyArg>(key));
+		new (&table[ind].elt) _EltT(std::forward<_Args>(args)...);
+		table[ind].hash = hash;
+	}
+	SSTD_INLINE void Destroy(const sizet& ind) noexcept {
+		if (std::is_destructible<_EltT>::value) {
+			table[ind].elt.~_EltT();
+		}
+		if (std::is_destructible<_KeyT>::value) {
+			table[ind].key.~_KeyT();
+		}
+	}
+
+	// Move construct slot src of other into the ( raw ) slot dst, and destruct the source
+	SSTD_INLINE void Move(const sizet& dst, _Inline_Storage& other, const sizet& src) {
+		_Move_Element(table[dst], other.table[src]);
+	}
+	// Both slots need to be full
+	SSTD_INLINE void Swap(const sizet& a, const sizet& b) {
+		alignas(_Map_Element) unsigned char tmp_memory[sizeof(_Map_Element)];
+		_Map_Element& tmp = *reinterpret_cast<_Map_Element*>(tmp_memory);
+		_Move_Element(tmp, table[a]);
+		_Move_Element(table[a], table[b]);
+		_Move_Element(table[b], tmp);
+	}
+
+	SSTD_INLINE static void _Move_Element(_Map_Element& dst, _Map_Element& src) {
+		new (&dst.key) _KeyT(std::move(src.key));
+		new (&dst.elt) _EltT(std::move(src.elt));
+		dst.hash = src.hash;
+		if (std::is_destructible<_KeyT>::value) {
+			src.key.~_KeyT();
+		}
+		if (std::is_destructible<_EltT>::value) {
+			src.elt.~_EltT();
+		}
+	}
+};
+
+// Keys ( and their hashes ) in one dense array, the elements in a parallel one
+// Probing only walks over the keys, the element is touched after the key matched
+// Use this when the elements are a lot bigger than the keys ( 8 byte keys with 256 byte elements for example ),
+// the memory a lookup probes through shrinks by about the same ratio
+template<typename _KeyT, typename _EltT>
+struct _Split_Storage {
+	struct _Key_Slot {
+		_KeyT key;
+		sizet hash;
+	};
+
+	static SSTD_CONSTEXPR bool flat = true;
+	static SSTD_CONSTEXPR bool trivially_destructible = std::is_trivially_destructible<_KeyT>::value && std::is_trivially_destructible<_EltT>::value;
+
+	_Key_Slot* keys = nullptr;
+	_EltT* elts = nullptr;
+
+	template<typename _AllocT>
+	SSTD_INLINE void Allocate(const sizet& capacity, _AllocT& alloc) {
+		keys = static_cast<_Key_Slot*>(alloc.allocate(sizeof(_Key_Slot) * capacity));
+		try {
+			elts = static_cast<_EltT*>(alloc.allocate(sizeof(_EltT) * capacity));
+		}
+		catch (...) {
+			alloc.deallocate(keys, sizeof(_Key_Slot) * capacity);
+			keys = nullptr;
+			throw;
+		}
+	}
+	template<typename _AllocT>
+	SSTD_INLINE void Deallocate(const sizet& capacity, _AllocT& alloc) noexcept {
+		if (keys) {
+			alloc.deallocate(keys, sizeof(_Key_Slot) * capacity);
+			alloc.deallocate(elts, sizeof(_EltT) * capacity);
+		}
+		keys = nullptr;
+		elts = nullptr;
+	}
+	template<typename _AllocT>
+	SSTD_INLINE void Release(_AllocT&) noexcept {}
+
+	SSTD_INLINE _KeyT& Key(const sizet& ind) const noexcept {
+		return keys[ind].key;
+	}
+	SSTD_INLINE _EltT& Elt(const sizet& ind) const noexcept {
+		return elts[ind];
+	}
+	SSTD_INLINE sizet Hash(const sizet& ind) const noexcept {
+		return keys[ind].hash;
+	}
+	SSTD_INLINE void Set_Hash(const sizet& ind, const sizet& hash) noexcept {
+		keys[ind].hash = hash;
+	}
+	SSTD_INLINE const void* Probe_Address(const sizet& ind) const noexcept {
+		return keys + ind;
+	}
+
+	// The elements start at the next 64 byte boundary after the keys
+	SSTD_INLINE static SSTD_CONSTEXPR sizet _Elts_Offset(const sizet& capacity) noexcept {
+		return _Align_Up(sizeof(_Key_Slot) * capacity, 64);
+	}
+	SSTD_INLINE static SSTD_CONSTEXPR sizet Bytes(const sizet& capacity) noexcept {
+		return _Elts_Offset(capacity) + sizeof(_EltT) * capacity;
+	}
+	SSTD_INLINE bool Write(std::FILE* file, const sizet& capacity) const {
+		return std::fwrite(keys, sizeof(_Key_Slot), capacity, file) == capacity
+			&& _Write_Padding(file, _Elts_Offset(capacity) - sizeof(_Key_Slot) * capacity)
+			&& std::fwrite(elts, sizeof(_EltT), capacity, file) == capacity;
+	}
+	SSTD_INLINE void Attach(unsigned char* memory, const sizet& capacity) noexcept {
+		keys = reinterpret_cast<_Key_Slot*>(memory);
+		elts = reinterpret_cast<_EltT*>(memory + _Elts_Offset(capacity));
+	}
+
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE void Construct(const sizet& ind, const sizet& hash, _KeyArg&& key, _Args&& ...args) {
+		new (&keys[ind].key) _KeyT(std::forward<_KeyArg>(key));
+		new (&elts[ind]) _EltT(std::forward<_Args>(args)...);
+		keys[ind].hash = hash;
+	}
+	SSTD_INLINE void Destroy(const sizet& ind) noexcept {
+		if (std::is_destructible<_EltT>::value) {
+			elts[ind].~_EltT();
+		}
+		if (std::is_destructible<_KeyT>::value) {
+			keys[ind].key.~_KeyT();
+		}
+	}
+
+	SSTD_INLINE void Move(const sizet& dst, _Split_Storage& other, const sizet& src) {
+		new (&keys[dst].key) _KeyT(std::move(other.keys[src].key));
+		new (&elts[dst]) _EltT(std::move(other.elts[src]));
+		keys[dst].hash = other.keys[src].hash;
+		other.Destroy(src);
+	}
+	SSTD_INLINE void Swap(const sizet& a, const sizet& b) {
+		alignas(_KeyT) unsigned char key_memory[sizeof(_KeyT)];
+		alignas(_EltT) unsigned char elt_memory[sizeof(_EltT)];
+		_KeyT& key = *reinterpret_cast<_KeyT*>(key_memory);
+		_EltT& elt = *reinterpret_cast<_EltT*>(elt_memory);
+		const sizet hash = keys[a].hash;
+
+		new (&key) _KeyT(std::move(keys[a].key));
+		new (&elt) _EltT(std::move(elts[a]));
+		Destroy(a);
+		Move(a, *this, b);
+		Construct(b, hash, std::move(key), std::move(elt));
+		if (std::is_destructible<_EltT>::value) {
+			elt.~_EltT();
+		}
+		if (std::is_destructible<_KeyT>::value) {
+			key.~_KeyT();
+		}
+	}
+};
+
+// Hands out nodes from big blocks ( slabs ), and reuses the freed ones through a free list
+// A node never moves, so pointers to it stay valid until it's freed
+// The blocks come from _AllocT, unless _AllocT serves nodes itself ( it has a node_size, see allocator.hpp ),
+// then every node is allocated from it one by one
+template<typename _NodeT, typename _AllocT = malloc_allocator>
+class _Node_Pool {
+public:
+	_Node_Pool() :
+		m_direct(_Serves_Nodes(m_alloc)) {
+
+	}
+	SSTD_EXPLICIT _Node_Pool(const _AllocT& alloc) :
+		m_alloc(alloc), m_direct(_Serves_Nodes(m_alloc)) {
+
+	}
+	_Node_Pool(const _Node_Pool&) = delete;
+	_Node_Pool& operator=(const _Node_Pool&) = delete;
+
+	~_Node_Pool() {
+		while (m_blocks) {
+			_Cell* next = m_blocks->next;
+			m_alloc.deallocate(m_blocks, sizeof(_Cell) * (_Block_Size(--m_block_count) + 1));
+			m_blocks = next;
+		}
+	}
+
+	// Raw memory for one node
+	SSTD_INLINE void* Allocate() {
+		if (m_direct) {
+			return m_alloc.allocate(sizeof(_Cell));
+		}
+		if (m_free) {
+			_Cell* cell = m_free;
+			m_free = cell->next;
+			return cell;
+		}
+		if (m_used == m_block_size) {
+			_New_Block();
+		}
+		return &m_blocks[1 + m_used++];
+	}
+
+	SSTD_INLINE void Deallocate(void* node) noexcept {
+		if (m_direct) {
+			m_alloc.deallocate(node, sizeof(_Cell));
+			return;
+		}
+		_Cell* cell = static_cast<_Cell*>(node);
+		cell->next = m_free;
+		m_free = cell;
+	}
+private:
+	union _Cell {
+		_Cell* next;
+		alignas(_NodeT) unsigned char memory[sizeof(_NodeT)];
+	};
+
+	_AllocT m_alloc;
+	// Nodes come from m_alloc one by one
+	const bool m_direct;
+	// The first cell of every block links to the previous block
+	_Cell* m_blocks = nullptr;
+	sizet m_block_count = 0;
+	_Cell* m_free = nullptr;
+	sizet m_used = 0;
+	sizet m_block_size = 0;
+
+	static SSTD_INLINE bool _Serves_Nodes(const _AllocT& alloc) noexcept {
+		if constexpr (_Has_Node_Size<_AllocT>::value) {
+			return sizeof(_Cell) <= alloc.node_size();
+		}
+		else {
+			(void)alloc;
+			return false;
+		}
+	}
+
+	// Every block is twice as big as the last one ( up to 1024 nodes )
+	SSTD_INLINE static SSTD_CONSTEXPR sizet _Block_Size(const sizet& block) noexcept {
+		return block < 6 ? sizet(16) << block : 1024;
+	}
+
+	SSTD_INLINE void _New_Block() {
+		const sizet block_size = _Block_Size(m_block_count);
+		_Cell* block = static_cast<_Cell*>(m_alloc.allocate(sizeof(_Cell) * (block_size + 1)));
+		++m_block_count;
+		block->next = m_blocks;
+		m_blocks = block;
+		m_block_size = block_size;
+		m_used = 0;
+	}
+};
+
+// Every key and element lives in its own node ( allocated from a _Node_Pool ), the table only holds the hash and a pointer
+// References to the keys and elements stay valid when the table grows or gets compacted,
+// and moving a slot around only moves a pointer, no matter how big the element is
+// The price is one more cache miss for every key comparison
+// The pool keeps its own copy of the allocator, so _AllocT has to be the one of the table
+template<typename _KeyT, typename _EltT, typename _AllocT = malloc_allocator>
+struct _Node_Storage {
+	struct _Node {
+		_KeyT key;
+		_EltT elt;
+	};
+	struct _Node_Slot {
+		_Node* node;
+		sizet hash;
+	};
+
+	// The nodes live outside the slot memory, so this can't be saved
+	static SSTD_CONSTEXPR bool flat = false;
+	// ( The slabs go back wholesale on Release, destructing the nodes is all Destroy does,
+	// but nodes allocated one by one from the allocator have to be given back one by one )
+	static SSTD_CONSTEXPR bool trivially_destructible = std::is_trivially_destructible<_KeyT>::value && std::is_trivially_destructible<_EltT>::value
+		&& !_Has_Node_Size<_AllocT>::value;
+
+	_Node_Slot* slots = nullptr;
+	// Shared by every table the map goes through, so it's a pointer
+	_Node_Pool<_Node, _AllocT>* pool = nullptr;
+
+	SSTD_INLINE void Allocate(const sizet& capacity, _AllocT& alloc) {
+		if (pool == nullptr) {
+			void* memory = alloc.allocate(sizeof(_Node_Pool<_Node, _AllocT>));
+			pool = new (memory) _Node_Pool<_Node, _AllocT>(alloc);
+		}
+		slots = static_cast<_Node_Slot*>(alloc.allocate(sizeof(_Node_Slot) * capacity));
+	}
+	SSTD_INLINE void Deallocate(const sizet& capacity, _AllocT& alloc) noexcept {
+		if (slots) {
+			alloc.deallocate(slots, sizeof(_Node_Slot) * capacity);
+		}
+		slots = nullptr;
+	}
+	SSTD_INLINE void Release(_AllocT& alloc) noexcept {
+		if (pool) {
+			pool->~_Node_Pool();
+			alloc.deallocate(pool, sizeof(_Node_Pool<_Node, _AllocT>));
+		}
+		pool = nullptr;
+	}
+
+	SSTD_INLINE _KeyT& Key(const sizet& ind) const noexcept {
+		return slots[ind].node->key;
+	}
+	SSTD_INLINE _EltT& Elt(const sizet& ind) const noexcept {
+		return slots[ind].node->elt;
+	}
+	SSTD_INLINE sizet Hash(const sizet& ind) const noexcept {
+		return slots[ind].hash;
+	}
+	SSTD_INLINE void Set_Hash(const sizet& ind, const sizet& hash) noexcept {
+		slots[ind].hash = hash;
+	}
+	SSTD_INLINE const void* Probe_Address(const sizet& ind) const noexcept {
+		return slots + ind;
+	}
+
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE void Construct(const sizet& ind, const sizet& hash, _KeyArg&& key, _Args&& ...args) {
+		void* memory = pool->Allocate();
+		try {
+			slots[ind].node = new (memory) _Node{ _KeyT(std::forward<_KeyArg>(key)), _EltT(std::forward<_Args>(args)...) };
+		}
+		catch (...) {
+			pool->Deallocate(memory);
+			throw;
+		}
+		slots[ind].hash = hash;
+	}
+	SSTD_INLINE void Destroy(const sizet& ind) noexcept {
+		slots[ind].node->~_Node();
+		pool->Deallocate(slots[ind].node);
+	}
+
+	SSTD_INLINE void Move(const sizet& dst, _Node_Storage& other, const sizet& src) noexcept {
+		slots[dst] = other.slots[src];
+	}
+	SSTD_INLINE void Swap(const sizet& a, const sizet& b) noexcept {
+		std::swap(slots[a], slots[b]);
+	}
+};
+
+// Only the key and its hash, for tables without elements ( see unordered_set.hpp )
+template<typename _KeyT>
+struct _Key_Storage {
+	struct _Key_Slot {
+		_KeyT key;
+		sizet hash;
+	};
+
+	static SSTD_CONSTEXPR bool flat = true;
+	static SSTD_CONSTEXPR bool trivially_destructible = std::is_trivially_destructible<_KeyT>::value;
+
+	_Key_Slot* table = nullptr;
+
+	template<typename _AllocT>
+	SSTD_INLINE void Allocate(const sizet& capacity, _AllocT& alloc) {
+		table = static_cast<_Key_Slot*>(alloc.allocate(sizeof(_Key_Slot) * capacity));
+	}
+	template<typename _AllocT>
+	SSTD_INLINE void Deallocate(const sizet& capacity, _AllocT& alloc) noexcept {
+		if (table) {
+			alloc.deallocate(table, sizeof(_Key_Slot) * capacity);
+		}
+		table = nullptr;
+	}
+	template<typename _AllocT>
+	SSTD_INLINE void Release(_AllocT&) noexcept {}
+
+	SSTD_INLINE _KeyT& Key(const sizet& ind) const noexcept {
+		return table[ind].key;
+	}
+	SSTD_INLINE sizet Hash(const sizet& ind) const noexcept {
+		return table[ind].hash;
+	}
+	SSTD_INLINE void Set_Hash(const sizet& ind, const sizet& hash) noexcept {
+		table[ind].hash = hash;
+	}
+	SSTD_INLINE const void* Probe_Address(const sizet& ind) const noexcept {
+		return table + ind;
+	}
+
+	SSTD_INLINE static SSTD_CONSTEXPR sizet Bytes(const sizet& capacity) noexcept {
+		return sizeof(_Key_Slot) * capacity;
+	}
+	SSTD_INLINE bool Write(std::FILE* file, const sizet& capacity) const {
+		return std::fwrite(table, sizeof(_Key_Slot), capacity, file) == capacity;
+	}
+	SSTD_INLINE void Attach(unsigned char* memory, const sizet&) noexcept {
+		table = reinterpret_cast<_Key_Slot*>(memory);
+	}
+
+	template<typename _KeyArg>
+	SSTD_INLINE void Construct(const sizet& ind, const sizet& hash, _KeyArg&& key) {
+		new (&table[ind].key) _KeyT(std::forward<_KeyArg>(key));
+		table[ind].hash = hash;
+	}
+	SSTD_INLINE void Destroy(const sizet& ind) noexcept {
+		if (std::is_destructible<_KeyT>::value) {
+			table[ind].key.~_KeyT();
+		}
+	}
+
+	SSTD_INLINE void Move(const sizet& dst, _Key_Storage& other, const sizet& src) {
+		new (&table[dst].key) _KeyT(std::move(other.table[src].key));
+		table[dst].hash = other.table[src].hash;
+		other.Destroy(src);
+	}
+	SSTD_INLINE void Swap(const sizet& a, const sizet& b) {
+		alignas(_KeyT) unsigned char key_memory[sizeof(_KeyT)];
+		_KeyT& key = *reinterpret_cast<_KeyT*>(key_memory);
+		const sizet hash = table[a].hash;
+
+		new (&key) _KeyT(std::move(table[a].key));
+		Destroy(a);
+		Move(a, *this, b);
+		Construct(b, hash, std::move(key));
+		if (std::is_destructible<_KeyT>::value) {
+			key.~_KeyT();
+		}
+	}
+};
+
+// -----------------------------------------
+//
+//   Table core
+//
+// -----------------------------------------
+
+// What _Hash_Table::stats reports
+// Everything but the rehash counters is measured on the spot by walking the table, so it's always there
+// The rehash counters are only tracked when SSTD_HASH_TABLE_STATS is defined ( otherwise they stay 0 ),
+// since they cost a clock read around every rehash
+struct hash_table_stats {
+	static SSTD_CONSTEXPR sizet histogram_size = 32;
+
+	sizet size = 0;
+	sizet capacity = 0;
+	sizet tombstones = 0;
+	Decimal load_factor = 0;
+	// Elements still waiting in the old table of an incremental rehash ( they aren't in the probe lengths below )
+	sizet migrating = 0;
+
+	// Probing steps from the home of an element to its slot ( a step covers a whole group with _Group_Prob )
+	sizet max_probe_length = 0;
+	Decimal average_probe_length = 0;
+	// probe_lengths[n] is how many elements sit n steps away from their home, the last one counts everything further
+	sizet probe_lengths[histogram_size] = {};
+
+	// Only with SSTD_HASH_TABLE_STATS
+	sizet rehashes = 0;
+	sizet compactions = 0;
+	sizet reseeds = 0;
+	// Time spent in rehashes and compactions ( an incremental rehash is spread over other calls, so it isn't in here )
+	Decimal rehash_milli = 0;
+};
+
+// Whether a table built from these can be relocated with its bytes ( see relocate.hpp )
+// The table itself only holds pointers to heap memory, so it's up to what else it carries around
+template<typename _Hash, typename _ProbT, typename _Storage, typename _AllocT>
+struct _Table_Relocatable : std::integral_constant<bool, std::is_trivially_copyable<_Hash>::value && std::is_trivially_copyable<_ProbT>::value
+	&& std::is_trivially_copyable<_Storage>::value && is_trivially_relocatable<_AllocT>::value> {};
+
+// The open addressing table sstd::unordered_map and sstd::unordered_set are built on
+// It owns the control bytes and the slots ( through _Storage ), and does all the probing, growing, compacting and reseeding
+// The core only ever looks at the keys, whatever else lives in a slot is up to the container on top of it
+// Slots are handed out as indices ( m_capacity means 'not found' ), the containers wrap them into their iterators
+//
+// The capacity is always a power of 2
+// Every table hashes with its own random seed, and gets a new one ( plus a rehash ) if an insert ever has to probe too far
+// So keys crafted to collide can't turn the table into a linear scan
+//
+// Growing normally moves every element in one go, inside whichever insert crossed the load factor
+// With incremental_rehash(true) the old table is kept next to the new one instead,
+// and every insert / erase after that moves a few more of its slots over ( see _Migrate )
+// Until that's done the lookups check both tables, and the slots of the old one are handed out
+// as m_capacity + 1 + ( index in the old table ), so m_capacity still means 'not found'
+//
+// The control bytes and the slots come from _AllocT ( see allocator.hpp )
+
+template<
+	typename _KeyT,	// Key type
+	typename _Hash, // Hash function
+	typename _ProbT, // probing function
+	typename _Storage, // slot layout
+	typename _AllocT = malloc_allocator // Where the memory comes from
+>
+class _Hash_Table {
+protected:
+	using _Group = _Ctrl_Group<_ProbT::group_width>;
+
+	_Hash_Table() SSTD_DEFAULT;
+	SSTD_EXPLICIT _Hash_Table(const _AllocT& alloc) :
+		m_alloc(alloc) {
+
+	}
+
+	// Copying would have to copy every key and element one by one ( and a node table every node ),
+	// so it's not done by accident, move the table instead
+	_Hash_Table(const _Hash_Table&) = delete;
+	_Hash_Table& operator=(const _Hash_Table&) = delete;
+
+	// Takes over the memory ( and the old table of an incremental rehash ), the seed and the allocator
+	// other is left empty, like after clear()
+	_Hash_Table(_Hash_Table&& other) noexcept(std::is_nothrow_move_constructible<_AllocT>::value) :
+		m_alloc(std::move(other.m_alloc)) {
+		_Take_From(other);
+	}
+	_Hash_Table& operator=(_Hash_Table&& other) noexcept(std::is_nothrow_move_assignable<_AllocT>::value) {
+		if (this != &other) {
+			clear();
+			m_alloc = std::move(other.m_alloc);
+			_Take_From(other);
+		}
+		return *this;
+	}
+public:
+
+	~_Hash_Table() {
+		clear();
+	}
+
+	// Destruct every key ( and whatever else is in the slots ), and free the table
+	// ( Trivially destructible slots are just freed, in an arena that makes clearing a table free )
+	SSTD_INLINE void clear() {
+		if constexpr (!_Storage::trivially_destructible) {
+			for (sizet i = 0; i < m_capacity; ++i) {
+				if (_Is_Full(m_ctrl[i])) {
+					m_slots.Destroy(i);
+				}
+			}
+			for (sizet i = 0; i < m_old_capacity; ++i) {
+				if (_Is_Full(m_old_ctrl[i])) {
+					m_old_slots.Destroy(i);
+				}
+			}
+		}
+		_Free_Old_Table();
+		m_slots.Deallocate(m_capacity, m_alloc);
+		m_slots.Release(m_alloc);
+		if (m_ctrl) {
+			m_alloc.deallocate(m_ctrl, sizeof(_Ctrl_T) * m_capacity);
+		}
+		m_ctrl = nullptr;
+		m_capacity = 0;
+		m_size = 0;
+		m_tombstones = 0;
+	}
+
+	// Malloc the additional _size ( and rehash everything into it )
+	SSTD_INLINE void reserve(const sizet& _size) {
+		if (m_ctrl == nullptr) {
+			_Malloc_Table(_size);
+		}
+		else {
+			_Rehash(m_capacity + _size);
+		}
+	}
+
+	SSTD_INLINE SSTD_CONSTEXPR sizet size() const noexcept {
+		return m_size;
+	}
+	SSTD_INLINE const _AllocT& get_allocator() const noexcept {
+		return m_alloc;
+	}
+	SSTD_INLINE SSTD_CONSTEXPR sizet capacity() const noexcept {
+		return m_capacity;
+	}
+	SSTD_INLINE SSTD_CONSTEXPR sizet empty() const noexcept {
+		return m_size == 0;
+	}
+
+	// Mantain this below max_load_factor
+	SSTD_INLINE SSTD_CONSTEXPR Decimal load_factor() const {
+		return static_cast<Decimal>(m_size) / (m_capacity ? m_capacity : 1);
+	}
+
+	// Whether growing is spread over the following inserts and erases ( off by default )
+	// Turning it off finishes the rehash that's going on
+	SSTD_INLINE void incremental_rehash(const bool& incremental) {
+		m_incremental = incremental;
+		if (!incremental) {
+			finish_rehash();
+		}
+	}
+	SSTD_INLINE bool incremental_rehash() const noexcept {
+		return m_incremental;
+	}
+	// Whether an incremental rehash is still going on
+	SSTD_INLINE bool rehashing() const noexcept {
+		return m_old_ctrl != nullptr;
+	}
+	// Move the rest of the old table over right now
+	SSTD_INLINE void finish_rehash() {
+		if (m_old_ctrl) {
+			_Migrate(m_old_capacity);
+		}
+	}
+
+	// Walks the whole table, so don't call this on a hot path ( see hash_table_stats )
+	SSTD_INLINE hash_table_stats stats() const {
+		hash_table_stats res;
+		res.size = m_size;
+		res.capacity = m_capacity;
+		res.tombstones = m_tombstones;
+		res.load_factor = load_factor();
+		sizet total = 0;
+		sizet count = 0;
+		for (sizet i = 0; i < m_capacity; ++i) {
+			if (!_Is_Full(m_ctrl[i])) {
+				continue;
+			}
+			const sizet length = _Probe_Length(i);
+			total += length;
+			++count;
+			res.max_probe_length = length > res.max_probe_length ? length : res.max_probe_length;
+			++res.probe_lengths[length < hash_table_stats::histogram_size ? length : hash_table_stats::histogram_size - 1];
+		}
+		res.average_probe_length = count ? static_cast<Decimal>(total) / count : 0;
+		res.migrating = m_size - count;
+#ifdef SSTD_HASH_TABLE_STATS
+		res.rehashes = m_rehashes;
+		res.compactions = m_compactions;
+		res.reseeds = m_reseeds;
+		res.rehash_milli = m_rehash_milli;
+#endif
+		return res;
+	}
+
+	// Print the stats, and the sizes of the clusters ( runs of full or deleted slots, which is what probing has to walk through )
+	SSTD_INLINE void dump_layout(std::ostream& out = std::cout) const {
+		const hash_table_stats info = stats();
+		out << "table: " << info.size << " / " << info.capacity << " slots full ( load " << info.load_factor << " ), "
+			<< info.tombstones << " deleted\n";
+		if (info.migrating) {
+			out << "incremental rehash: " << info.migrating << " elements still in the old table\n";
+		}
+		out << "probe lengths: max " << info.max_probe_length << ", average " << info.average_probe_length << "\n";
+		for (sizet i = 0; i < hash_table_stats::histogram_size; ++i) {
+			if (info.probe_lengths[i]) {
+				out << "  " << i << (i + 1 == hash_table_stats::histogram_size ? "+" : "") << ": " << info.probe_lengths[i] << "\n";
+			}
+		}
+#ifdef SSTD_HASH_TABLE_STATS
+		out << "rehashes: " << info.rehashes << ", compactions: " << info.compactions << ", reseeds: " << info.reseeds
+			<< ", " << info.rehash_milli << " ms\n";
+#endif
+
+		// clusters[n] counts the clusters of 2^n to 2^(n+1) - 1 slots
+		sizet clusters[sizeof(sizet) * 8] = {};
+		sizet count = 0;
+		sizet longest = 0;
+		sizet used = 0;
+		const auto add_cluster = [&](const sizet& length) {
+			if (length == 0) {
+				return;
+			}
+			sizet bucket = 0;
+			while ((length >> (bucket + 1)) != 0) {
+				++bucket;
+			}
+			++clusters[bucket];
+			++count;
+			used += length;
+			longest = length > longest ? length : longest;
+		};
+		// Start at an empty slot, so the cluster wrapping around the end is counted once
+		sizet start = 0;
+		while (start < m_capacity && m_ctrl[start] != _Ctrl_Empty) {
+			++start;
+		}
+		if (start == m_capacity) {
+			// No empty slot at all, the whole table is one cluster
+			add_cluster(m_capacity);
+		}
+		else {
+			sizet run = 0;
+			// ( The last slot visited is start again, which ends the last cluster )
+			for (sizet i = 1; i <= m_capacity; ++i) {
+				if (m_ctrl[(start + i) & (m_capacity - 1)] != _Ctrl_Empty) {
+					++run;
+					continue;
+				}
+				add_cluster(run);
+				run = 0;
+			}
+		}
+		out << "clusters: " << count << ", longest " << longest << ", average " << (count ? static_cast<Decimal>(used) / count : 0) << "\n";
+		for (sizet i = 0; i < sizeof(sizet) * 8; ++i) {
+			if (clusters[i]) {
+				out << "  " << (sizet(1) << i) << "-" << ((sizet(1) << (i + 1)) - 1) << ": " << clusters[i] << "\n";
+			}
+		}
+	}
+protected:
+	_AllocT m_alloc;
+	_Storage m_slots;
+	_Ctrl_T* m_ctrl = nullptr;
+
+	const _Hash m_Hasher{};
+	const _ProbT m_prob{};
+
+	sizet m_size = 0;
+	sizet m_capacity = 0;
+	// Amount of slots marked as deleted
+	sizet m_tombstones = 0;
+
+	Decimal m_max_load_factor = _ProbT::max_load_factor;
+	// Compact the table once this ratio of the slots are deleted
+	Decimal m_max_tombstone_ratio = 0.25;
+
+	// The table an incremental rehash is moving out of ( m_old_ctrl is nullptr when there is none )
+	_Storage m_old_slots;
+	_Ctrl_T* m_old_ctrl = nullptr;
+	sizet m_old_capacity = 0;
+	// The slots of the old table before this are moved already
+	sizet m_migrated = 0;
+	bool m_incremental = false;
+
+	uint64 m_seed = _Random_Seed();
+	// Reseeding rehashes everything, so it needs this many inserts ( a quarter of the size ) to pay for it first
+	// ( Otherwise a hash function that collides no matter the seed would rehash on every insert )
+	sizet m_inserts_since_reseed = 0;
+
+#ifdef SSTD_HASH_TABLE_STATS
+	sizet m_rehashes = 0;
+	sizet m_compactions = 0;
+	sizet m_reseeds = 0;
+	Decimal m_rehash_milli = 0;
+#endif
+
+	// How many slots of the old table every insert / erase moves over during an incremental rehash
+	// The new table is twice as big, so the old one is empty long before the new one fills up
+	static SSTD_CONSTEXPR sizet _Migrate_Step = 16;
+
+	// How many keys apart the stages of the _Find_Batch pipeline are
+	static SSTD_CONSTEXPR sizet _Batch_Distance = 16;
+	// Holds the hashes of every key in the pipeline ( more than 2 * _Batch_Distance, and a power of 2 )
+	static SSTD_CONSTEXPR sizet _Batch_Ring = 64;
+	static_assert(_Batch_Ring > 2 * _Batch_Distance, "The pipeline of _Find_Batch doesn't fit in its ring");
+
+	// The capacity is rounded up to a power of 2 ( and at least one group ),
+	// so the probing functors can mask, and a probing step never reads past the control array
+	SSTD_INLINE SSTD_CONSTEXPR static sizet _Round_Capacity(const sizet& memsize) noexcept {
+		return _Round_Up_Power_Of_2(memsize > _ProbT::group_width ? memsize : _ProbT::group_width);
+	}
+
+	// Everything but the allocator ( and the stateless hash / probing functors ), other ends up without a table
+	// ( The storage is a handful of pointers, copying it is what moves the slots, see _Rehash )
+	SSTD_INLINE void _Take_From(_Hash_Table& other) noexcept {
+		m_slots = other.m_slots;
+		m_ctrl = other.m_ctrl;
+		m_size = other.m_size;
+		m_capacity = other.m_capacity;
+		m_tombstones = other.m_tombstones;
+		m_max_load_factor = other.m_max_load_factor;
+		m_max_tombstone_ratio = other.m_max_tombstone_ratio;
+		m_old_slots = other.m_old_slots;
+		m_old_ctrl = other.m_old_ctrl;
+		m_old_capacity = other.m_old_capacity;
+		m_migrated = other.m_migrated;
+		m_incremental = other.m_incremental;
+		m_seed = other.m_seed;
+		m_inserts_since_reseed = other.m_inserts_since_reseed;
+#ifdef SSTD_HASH_TABLE_STATS
+		m_rehashes = other.m_rehashes;
+		m_compactions = other.m_compactions;
+		m_reseeds = other.m_reseeds;
+		m_rehash_milli = other.m_rehash_milli;
+#endif
+
+		other.m_slots = _Storage();
+		other.m_ctrl = nullptr;
+		other.m_size = 0;
+		other.m_capacity = 0;
+		other.m_tombstones = 0;
+		other.m_old_slots = _Storage();
+		other.m_old_ctrl = nullptr;
+		other.m_old_capacity = 0;
+		other.m_migrated = 0;
+		other.m_inserts_since_reseed = 0;
+	}
+
+	SSTD_INLINE void _Malloc_Table(const sizet& memsize) {
+		m_capacity = _Round_Capacity(memsize);
+		m_slots.Allocate(m_capacity, m_alloc);
+		m_ctrl = static_cast<_Ctrl_T*>(m_alloc.allocate(sizeof(_Ctrl_T) * m_capacity));
+		std::memset(m_ctrl, _Ctrl_Empty, sizeof(_Ctrl_T) * m_capacity);
+	}
+
+	// Make sure count elements fit in without growing
+	SSTD_INLINE void _Reserve_Elements(const sizet& count) {
+		const sizet needed = static_cast<sizet>(count / m_max_load_factor) + 1;
+		if (m_ctrl == nullptr) {
+			_Malloc_Table(needed);
+		}
+		else if (needed > m_capacity) {
+			_Rehash(needed);
+		}
+	}
+
+	// Move every element into a fresh table of ( at least ) memsize slots
+	// Every element is placed using its cached hash, the hash function is never called
+	// ( Unless the seed changed, then every key is hashed again )
+	// This also gets rid of all the deleted slots
+	SSTD_INLINE void _Rehash(const sizet& memsize, const bool& rehash_keys = false) {
+		finish_rehash();
+#ifdef SSTD_HASH_TABLE_STATS
+		Clock clock;
+#endif
+		_Storage old_slots = m_slots;
+		_Ctrl_T* old_ctrl = m_ctrl;
+		const sizet old_capacity = m_capacity;
+
+		_Malloc_Table(memsize);
+		m_tombstones = 0;
+		for (sizet i = 0; i < old_capacity; ++i) {
+			if (_Is_Full(old_ctrl[i])) {
+				const sizet hash = rehash_keys ? _Hash_Key(old_slots.Key(i)) : old_slots.Hash(i);
+				const sizet ind = _Free_Index(hash);
+				m_ctrl[ind] = _Hash_Fragment(hash);
+				m_slots.Move(ind, old_slots, i);
+				m_slots.Set_Hash(ind, hash);
+			}
+		}
+		old_slots.Deallocate(old_capacity, m_alloc);
+		m_alloc.deallocate(old_ctrl, sizeof(_Ctrl_T) * old_capacity);
+#ifdef SSTD_HASH_TABLE_STATS
+		++m_rehashes;
+		m_rehash_milli += clock.End().asMilli;
+#endif
+	}
+
+	// Get rid of the deleted slots without allocating a new table
+	// First mark every deleted slot as empty, and every full slot as deleted ( meaning 'needs to be placed again' )
+	// Then walk through the table and put each of those elements to the first free slot of its probing sequence
+	// If that slot holds another element that still needs to be placed, swap them and handle the swapped one next
+	SSTD_INLINE void _Compact() {
+#ifdef SSTD_HASH_TABLE_STATS
+		Clock clock;
+#endif
+		for (sizet i = 0; i < m_capacity; ++i) {
+			m_ctrl[i] = _Is_Full(m_ctrl[i]) ? _Ctrl_Deleted : _Ctrl_Empty;
+		}
+
+		for (sizet i = 0; i < m_capacity; ++i) {
+			if (m_ctrl[i] != _Ctrl_Deleted) {
+				continue;
+			}
+			const sizet hash = m_slots.Hash(i);
+			const sizet ind = _Find_Free_Index(hash);
+			// Already in the right group, just leave it there
+			if (ind / _ProbT::group_width == i / _ProbT::group_width) {
+				m_ctrl[i] = _Hash_Fragment(hash);
+				continue;
+			}
+			if (m_ctrl[ind] == _Ctrl_Empty) {
+				m_slots.Move(ind, m_slots, i);
+				m_ctrl[ind] = _Hash_Fragment(hash);
+				m_ctrl[i] = _Ctrl_Empty;
+			}
+			else {
+				// Swap with the element that still needs to be placed
+				m_slots.Swap(ind, i);
+				m_ctrl[ind] = _Hash_Fragment(hash);
+				// Handle the swapped element next
+				--i;
+			}
+		}
+		m_tombstones = 0;
+#ifdef SSTD_HASH_TABLE_STATS
+		++m_compactions;
+		m_rehash_milli += clock.End().asMilli;
+#endif
+	}
+
+	// Mantain the used slots ( elements + deleted slots ) below the max_load_factor
+	// If a lot of them are deleted slots, compacting the table is enough
+	SSTD_INLINE void _Check_Load() {
+		if (static_cast<Decimal>(m_size + m_tombstones) < m_capacity * m_max_load_factor) {
+			return;
+		}
+		if (load_factor() < m_max_load_factor / 2) {
+			_Compact();
+		}
+		else if (m_incremental) {
+			_Start_Migration(m_capacity * 2);
+		}
+		else {
+			_Rehash(m_capacity * 2);
+		}
+	}
+
+	// Start an incremental rehash into a fresh table of ( at least ) memsize slots
+	// Nothing is moved yet, the following inserts / erases do that
+	SSTD_INLINE void _Start_Migration(const sizet& memsize) {
+		// ( The last one didn't finish in time, which only happens if the table is allowed to fill up really fast )
+		finish_rehash();
+		m_old_slots = m_slots;
+		m_old_ctrl = m_ctrl;
+		m_old_capacity = m_capacity;
+		m_migrated = 0;
+#ifdef SSTD_HASH_TABLE_STATS
+		++m_rehashes;
+#endif
+		// ( Allocating only replaces the slot memory m_slots points to, m_old_slots still has the old one )
+		_Malloc_Table(memsize);
+		m_tombstones = 0;
+	}
+
+	// Walk the probing sequence group by group
+	// Only the slots whose control byte matches the hash fragment get their ( cached ) hash and key compared
+	// Returns m_capacity if the key doesn't exist
+	template<typename _KeyLike>
+	SSTD_INLINE sizet _Find_Index(const _KeyLike& key) const {
+		if (m_ctrl == nullptr) {
+			return m_capacity;
+		}
+		return _Find_Index(key, _Hash_Key(key));
+	}
+	template<typename _KeyLike>
+	SSTD_INLINE sizet _Find_Index(const _KeyLike& key, const sizet& hash) const {
+		const sizet ind = _Find_In(m_ctrl, m_slots, m_capacity, key, hash);
+		if (ind != m_capacity || m_old_ctrl == nullptr) {
+			return ind;
+		}
+		// Not moved over yet?
+		const sizet old = _Find_In(m_old_ctrl, m_old_slots, m_old_capacity, key, hash);
+		return old == m_old_capacity ? m_capacity : m_capacity + 1 + old;
+	}
+	// The lookup itself, in either the table or the old table
+	template<typename _KeyLike>
+	SSTD_INLINE sizet _Find_In(const _Ctrl_T* ctrl, const _Storage& slots, const sizet& capacity, const _KeyLike& key, const sizet& hash) const {
+		if constexpr (_ProbT::robin_hood) {
+			return _Robin_Hood_Find_In(ctrl, slots, capacity, key, hash);
+		}
+		const _Ctrl_T fragment = _Hash_Fragment(hash);
+		const sizet groups = capacity / _ProbT::group_width;
+		for (sizet i = 0; i != groups; ++i) {
+			const sizet base = m_prob(hash, i, capacity - 1);
+			uint32 match = _Group::Match(ctrl + base, fragment);
+			while (match) {
+				const sizet ind = base + _Count_Trailing_Zeros(match);
+				if (slots.Hash(ind) == hash && slots.Key(ind) == key) {
+					return ind;
+				}
+				match &= match - 1;
+			}
+			// An empty slot ends the probing sequence
+			if (_Group::Match_Empty(ctrl + base)) {
+				return capacity;
+			}
+		}
+		return capacity;
+	}
+
+	// The first empty ( or deleted ) slot on the probing sequence of hash
+	// steps is how many probing steps it took to get there
+	SSTD_INLINE sizet _Find_Free_Index(const sizet& hash, sizet& steps) const {
+		const sizet groups = m_capacity / _ProbT::group_width;
+		for (steps = 0; steps != groups; ++steps) {
+			const sizet base = m_prob(hash, steps, m_capacity - 1);
+			const uint32 free_mask = _Group::Match_Empty_Or_Deleted(m_ctrl + base);
+			if (free_mask) {
+				return base + _Count_Trailing_Zeros(free_mask);
+			}
+		}
+		// The table is full ( which won't happen, or something is really REALLY wrong)
+		return m_capacity;
+	}
+	SSTD_INLINE sizet _Find_Free_Index(const sizet& hash) const {
+		sizet steps;
+		return _Find_Free_Index(hash, steps);
+	}
+
+	// The slot a new element with hash goes to ( the slot is free after this )
+	SSTD_INLINE sizet _Free_Index(const sizet& hash) {
+		if constexpr (_ProbT::robin_hood) {
+			sizet dist;
+			return _Robin_Hood_Make_Room(_Robin_Hood_Target(hash, dist));
+		}
+		else {
+			return _Take_Free(_Find_Free_Index(hash));
+		}
+	}
+
+	// A deleted slot that gets reused isn't a tombstone anymore
+	SSTD_INLINE sizet _Take_Free(const sizet& ind) noexcept {
+		if (ind != m_capacity && m_ctrl[ind] == _Ctrl_Deleted) {
+			--m_tombstones;
+		}
+		return ind;
+	}
+
+	// _Free_Index, but for a brand new element, so the load factor ( and the probing length ) is checked first
+	// If the probing sequence is too long, the watchdog may reseed the table, then hash is updated for the new seed
+	template<typename _KeyLike>
+	SSTD_INLINE sizet _Claim_Index(sizet& hash, const _KeyLike& key) {
+		_Check_Load();
+		if constexpr (_ProbT::robin_hood) {
+			sizet dist;
+			sizet ind = _Robin_Hood_Target(hash, dist);
+			if (dist > _ProbT::max_probe_length && _Probe_Alarm()) {
+				hash = _Hash_Key(key);
+				ind = _Robin_Hood_Target(hash, dist);
+			}
+			return _Robin_Hood_Make_Room(ind);
+		}
+		else {
+			sizet steps;
+			sizet ind = _Find_Free_Index(hash, steps);
+			if (steps > _ProbT::max_probe_length && _Probe_Alarm()) {
+				hash = _Hash_Key(key);
+				ind = _Find_Free_Index(hash);
+			}
+			return _Take_Free(ind);
+		}
+	}
+
+	// The watchdog, called when a new element would end up too far away from its home slot
+	// With a decent hash and seed that ( almost ) never happens, so the keys are most likely crafted to collide:
+	// Pick a new seed and hash everything again ( and grow while at it, if the table is getting full anyway )
+	// A bad streak on a full table is also possible, then growing is what fixes it
+	// Returns whether the table changed
+	SSTD_INLINE bool _Probe_Alarm() {
+		const bool grow = load_factor() >= m_max_load_factor / 2;
+		if (m_inserts_since_reseed >= m_size / 4) {
+			m_seed = _Random_Seed();
+			m_inserts_since_reseed = 0;
+#ifdef SSTD_HASH_TABLE_STATS
+			++m_reseeds;
+#endif
+			_Rehash(grow ? m_capacity * 2 : m_capacity, true);
+			return true;
+		}
+		if (grow) {
+			_Rehash(m_capacity * 2);
+			return true;
+		}
+		return false;
+	}
+
+	// Stops at the first slot that is closer to its home than the key would be
+	// ( The moved out slots of an old table are marked as deleted, and keep their hash, so they still block the way like before )
+	template<typename _KeyLike>
+	SSTD_INLINE sizet _Robin_Hood_Find_In(const _Ctrl_T* ctrl, const _Storage& slots, const sizet& capacity, const _KeyLike& key, const sizet& hash) const {
+		const _Ctrl_T fragment = _Hash_Fragment(hash);
+		for (sizet i = 0; i != capacity; ++i) {
+			const sizet ind = m_prob(hash, i, capacity - 1);
+			if (ctrl[ind] == _Ctrl_Empty || m_prob.distance(slots.Hash(ind), ind, capacity - 1) < i) {
+				return capacity;
+			}
+			if (ctrl[ind] == fragment && slots.Hash(ind) == hash && slots.Key(ind) == key) {
+				return ind;
+			}
+		}
+		return capacity;
+	}
+
+	// The first slot that is empty, or whose element is closer to its home than the new one would be
+	// dist is how far that slot is from the home of hash
+	SSTD_INLINE sizet _Robin_Hood_Target(const sizet& hash, sizet& dist) const {
+		sizet ind = m_prob(hash, 0, m_capacity - 1);
+		for (dist = 0; dist != m_capacity; ++dist, ind = m_prob(hash, dist, m_capacity - 1)) {
+			if (m_ctrl[ind] == _Ctrl_Empty || m_prob.distance(m_slots.Hash(ind), ind, m_capacity - 1) < dist) {
+				break;
+			}
+		}
+		return ind;
+	}
+
+	// The elements from ind till the next empty slot all get shifted one slot further
+	// ( which keeps every cluster sorted by home slot )
+	SSTD_INLINE sizet _Robin_Hood_Make_Room(const sizet& ind) {
+		sizet empty = ind;
+		while (m_ctrl[empty] != _Ctrl_Empty) {
+			empty = (empty + 1) & (m_capacity - 1);
+		}
+		while (empty != ind) {
+			const sizet prev = (empty - 1) & (m_capacity - 1);
+			m_slots.Move(empty, m_slots, prev);
+			m_ctrl[empty] = m_ctrl[prev];
+			empty = prev;
+		}
+		m_ctrl[ind] = _Ctrl_Empty;
+		return ind;
+	}
+
+	// The user hash, mixed once more unless it avalanches already ( this is what gets cached and probed with )
+	template<typename _KeyLike>
+	SSTD_INLINE sizet _Hash_Key(const _KeyLike& key) const {
+		return _Table_Hash(m_Hasher, key, m_seed);
+	}
+
+	// Construct the slot in place, only if the key doesn't exist yet
+	// The key is moved in if it's an rvalue, the rest of args go to _Storage::Construct
+	// Returns the slot of the key, and whether it was inserted
+	// ( The hash may change, if the watchdog reseeds the table )
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE std::pair<sizet, bool> _Emplace_Hash(sizet hash, _KeyArg&& key, _Args&& ...args) {
+		if (m_ctrl == nullptr) {
+			_Malloc_Table(4);
+			// Yet another magic number
+			// ( Just kidding, set it to 4 so it will not trigger the reallocation until the 3rd insert )
+		}
+		if (m_old_ctrl) {
+			_Migrate(_Migrate_Step);
+		}
+		// That block has the same key
+		const sizet found = _Find_Index(key, hash);
+		if (found < m_capacity) {
+			return { found, false };
+		}
+		if (found > m_capacity) {
+			// Still in the old table, move it over now, so the slot handed out is a normal one
+			return { _Migrate_Slot(found - m_capacity - 1), false };
+		}
+		const sizet ind = _Claim_Index(hash, key);
+		if (ind == m_capacity) {
+			return { m_capacity, false };
+		}
+
+		// Construct it
+		m_slots.Construct(ind, hash, std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+
+		// Acquire it
+		m_ctrl[ind] = _Hash_Fragment(hash);
+		++m_size;
+		++m_inserts_since_reseed;
+
+		return { ind, true };
+	}
+
+	// Erase the key
+	// The slot is marked as deleted instead of empty, so the probing sequences going through it stay intact
+	// Unless its group still has an empty slot, then no probing sequence has ever gone past that group
+	// And the table gets compacted once there are too many deleted slots
+	SSTD_INLINE bool _Erase(const _KeyT& key) {
+		if (m_old_ctrl) {
+			_Migrate(_Migrate_Step);
+		}
+		return _Erase_Index(_Find_Index(key));
+	}
+	SSTD_INLINE bool _Erase_Index(const sizet& ind) {
+		if (ind == m_capacity) {
+			return false;
+		}
+		if (ind > m_capacity) {
+			// In the old table, which only ever gets emptied, so marking it deleted is enough
+			const sizet old = ind - m_capacity - 1;
+			m_old_slots.Destroy(old);
+			m_old_ctrl[old] = _Ctrl_Deleted;
+			--m_size;
+			return true;
+		}
+		if constexpr (_ProbT::robin_hood) {
+			_Robin_Hood_Erase(ind);
+			return true;
+		}
+		const sizet base = ind / _ProbT::group_width * _ProbT::group_width;
+		if (_ProbT::group_width > 1 && _Group::Match_Empty(m_ctrl + base)) {
+			m_ctrl[ind] = _Ctrl_Empty;
+		}
+		else {
+			m_ctrl[ind] = _Ctrl_Deleted;
+			++m_tombstones;
+		}
+		m_slots.Destroy(ind);
+		--m_size;
+
+		if (m_tombstones > m_capacity * m_max_tombstone_ratio) {
+			_Compact();
+		}
+		return true;
+	}
+
+	// Backward shift deletion
+	// Shift the following elements one slot back, until an empty slot or an element that is already at its home
+	SSTD_INLINE void _Robin_Hood_Erase(sizet ind) {
+		m_slots.Destroy(ind);
+		--m_size;
+
+		sizet next = (ind + 1) & (m_capacity - 1);
+		while (m_ctrl[next] != _Ctrl_Empty && m_prob.distance(m_slots.Hash(next), next, m_capacity - 1) != 0) {
+			m_slots.Move(ind, m_slots, next);
+			m_ctrl[ind] = m_ctrl[next];
+			ind = next;
+			next = (next + 1) & (m_capacity - 1);
+		}
+		m_ctrl[ind] = _Ctrl_Empty;
+	}
+
+	// How many probing steps it took to get from the home of the element in slot ind to ind
+	SSTD_INLINE sizet _Probe_Length(const sizet& ind) const noexcept {
+		const sizet hash = m_slots.Hash(ind);
+		if constexpr (_ProbT::robin_hood) {
+			return m_prob.distance(hash, ind, m_capacity - 1);
+		}
+		else {
+			const sizet base = ind / _ProbT::group_width * _ProbT::group_width;
+			const sizet groups = m_capacity / _ProbT::group_width;
+			sizet steps = 0;
+			while (steps != groups && m_prob(hash, steps, m_capacity - 1) != base) {
+				++steps;
+			}
+			return steps;
+		}
+	}
+
+	// Move up to count slots of the old table over, and free it once it's empty
+	SSTD_INLINE void _Migrate(const sizet& count) {
+		const sizet last = m_old_capacity - m_migrated < count ? m_old_capacity : m_migrated + count;
+		for (; m_migrated < last; ++m_migrated) {
+			if (_Is_Full(m_old_ctrl[m_migrated])) {
+				_Migrate_Slot(m_migrated);
+			}
+		}
+		if (m_migrated == m_old_capacity) {
+			_Free_Old_Table();
+		}
+	}
+	// Move the element in slot old of the old table over, returns its new slot
+	// The old slot is marked as deleted, not empty, so the probing sequences going through it stay intact
+	SSTD_INLINE sizet _Migrate_Slot(const sizet& old) {
+		const sizet hash = m_old_slots.Hash(old);
+		const sizet ind = _Free_Index(hash);
+		m_ctrl[ind] = _Hash_Fragment(hash);
+		m_slots.Move(ind, m_old_slots, old);
+		m_old_ctrl[old] = _Ctrl_Deleted;
+		return ind;
+	}
+	// ( Only the slot memory, the rest of the storage is shared with the table )
+	SSTD_INLINE void _Free_Old_Table() noexcept {
+		if (m_old_ctrl == nullptr) {
+			return;
+		}
+		m_old_slots.Deallocate(m_old_capacity, m_alloc);
+		m_alloc.deallocate(m_old_ctrl, sizeof(_Ctrl_T) * m_old_capacity);
+		m_old_ctrl = nullptr;
+		m_old_capacity = 0;
+		m_migrated = 0;
+	}
+
+	// The key in slot ind ( which can be in the old table, see _Find_Index )
+	SSTD_INLINE _KeyT& _Key_At(const sizet& ind) const noexcept {
+		return ind < m_capacity ? m_slots.Key(ind) : m_old_slots.Key(ind - m_capacity - 1);
+	}
+
+	// Iteration order: the old table ( if there is one ) first, then the table, and m_capacity is the end
+	SSTD_INLINE sizet _First_Full() const noexcept {
+		return _Next_Full(m_old_ctrl ? m_capacity + 1 : 0);
+	}
+	// The first full slot at or after ind, in iteration order ( m_capacity if there is none )
+	SSTD_INLINE sizet _Next_Full(sizet ind) const noexcept {
+		if (ind > m_capacity) {
+			const sizet old = _Next_Full_In(m_old_ctrl, ind - m_capacity - 1, m_old_capacity);
+			if (old < m_old_capacity) {
+				return m_capacity + 1 + old;
+			}
+			ind = 0;
+		}
+		return _Next_Full_In(m_ctrl, ind, m_capacity);
+	}
+
+	// Look up count keys at once, found(i, slot) is called with the slot of keys[i] ( m_capacity if it doesn't exist )
+	// The lookups are pipelined, so the cache misses of _Batch_Distance keys are in flight while one gets resolved:
+	// - key i is hashed, and the control bytes of its first probing step prefetched
+	// - _Batch_Distance keys later its control bytes are there, the slot its hash fragment matches gets prefetched
+	// - another _Batch_Distance keys later that slot is there as well, and key i is resolved for real
+	// So on a table way bigger than the cache, a lookup pays for its misses about in parallel instead of one after another
+	template<typename _Found>
+	SSTD_INLINE void _Find_Batch(const _KeyT* keys, const sizet& count, _Found&& found) const {
+		if (m_ctrl == nullptr) {
+			for (sizet i = 0; i < count; ++i) {
+				found(i, m_capacity);
+			}
+			return;
+		}
+		// The hashes of the keys still in the pipeline ( by index modulo _Batch_Ring )
+		sizet hashes[_Batch_Ring];
+		const sizet mask = m_capacity - 1;
+		for (sizet t = 0; t < count + 2 * _Batch_Distance; ++t) {
+			if (t < count) {
+				const sizet hash = _Hash_Key(keys[t]);
+				hashes[t % _Batch_Ring] = hash;
+				SSTD_PREFETCH(m_ctrl + m_prob(hash, 0, mask));
+			}
+			if (t >= _Batch_Distance && t - _Batch_Distance < count) {
+				const sizet hash = hashes[(t - _Batch_Distance) % _Batch_Ring];
+				const sizet base = m_prob(hash, 0, mask);
+				const uint32 match = _Group::Match(m_ctrl + base, _Hash_Fragment(hash));
+				if (match) {
+					SSTD_PREFETCH(m_slots.Probe_Address(base + _Count_Trailing_Zeros(match)));
+				}
+				else if (!_Group::Match_Empty(m_ctrl + base)) {
+					// The probing goes on to the next step, start loading that one instead
+					const sizet next = m_prob(hash, 1, mask);
+					SSTD_PREFETCH(m_ctrl + next);
+					SSTD_PREFETCH(m_slots.Probe_Address(next));
+				}
+			}
+			if (t >= 2 * _Batch_Distance) {
+				const sizet i = t - 2 * _Batch_Distance;
+				found(i, _Find_Index(keys[i], hashes[i % _Batch_Ring]));
+			}
+		}
+	}
+};
+
+SSTD_END
+
+#endif
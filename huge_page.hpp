@@ -0,0 +1,239 @@
+#ifndef SSTD_HUGE_PAGE_INCLUDED
+#define SSTD_HUGE_PAGE_INCLUDED
+
+#include "core.hpp"
+#include "allocator.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+SSTD_BEGIN
+
+// Which pages a huge_page_allocator maps its memory with
+enum class huge_pages {
+	// The normal 4 KiB pages ( and no transparent huge pages either ), mostly there to compare against
+	none,
+	// 2 MiB pages whenever the kernel has them ( MADV_HUGEPAGE ), the normal pages otherwise
+	transparent,
+	// 2 MiB pages from the reserved pool ( MAP_HUGETLB on linux, MEM_LARGE_PAGES on windows ),
+	// falls back to transparent if there aren't enough reserved ( see vm.nr_hugepages / the "Lock pages in memory" privilege )
+	reserved
+};
+
+// Memory for big containers, a table of a few GB spends most of a random lookup waiting on TLB misses with 4 KiB pages,
+// with 2 MiB pages the whole translation of a lookup is a lot more likely to be cached
+//
+// Requests of at least _Huge_Page_Bytes get their own mapping ( rounded up to whole huge pages ), smaller ones go to malloc,
+// so the small tables and vectors of a program don't each burn a 2 MiB page
+// A mapping can be bound to a NUMA node ( the node of the threads using the container ), so its pages never end up on another one
+//
+// Growing a mapping goes through mremap, which only moves the page tables around, so a vector of trivially relocatable elements
+// never copies its bytes when it grows ( see vector::_Realloc_Data )
+// Mappings of reserved huge pages usually can't be mremapped, those copy like everything else
+//
+// A cheap handle, pass it to the container ( see allocator.hpp ):
+//
+//   sstd::vector<uint64, 0, sstd::huge_page_allocator> v(sstd::huge_page_allocator(sstd::huge_pages::transparent, 1));
+class huge_page_allocator {
+public:
+	// node is the NUMA node to bind the memory to ( -1 lets the kernel pick like usual )
+	huge_page_allocator(const huge_pages& pages = huge_pages::transparent, const int& node = -1) noexcept :
+		m_pages(pages), m_node(node) {
+
+	}
+
+	SSTD_INLINE void* allocate(const sizet& bytes) {
+		if (bytes < _Huge_Page_Bytes) {
+			return malloc_allocator().allocate(bytes);
+		}
+		return _Map(_Map_Bytes(bytes));
+	}
+	SSTD_INLINE void deallocate(void* ptr, const sizet& bytes) noexcept {
+		if (ptr == nullptr) {
+			return;
+		}
+		if (bytes < _Huge_Page_Bytes) {
+			malloc_allocator().deallocate(ptr, bytes);
+			return;
+		}
+		_Unmap(ptr, _Map_Bytes(bytes));
+	}
+	SSTD_INLINE void* reallocate(void* ptr, const sizet& old_bytes, const sizet& new_bytes) {
+		if (ptr == nullptr) {
+			return allocate(new_bytes);
+		}
+		if (old_bytes < _Huge_Page_Bytes && new_bytes < _Huge_Page_Bytes) {
+			return malloc_allocator().reallocate(ptr, old_bytes, new_bytes);
+		}
+#if defined(__linux__)
+		if (old_bytes >= _Huge_Page_Bytes && new_bytes >= _Huge_Page_Bytes) {
+			void* res = _Remap(ptr, _Map_Bytes(old_bytes), _Map_Bytes(new_bytes));
+			if (res != nullptr) {
+				return res;
+			}
+		}
+#endif
+		// Crossing between malloc and a mapping ( or a mapping that can't be remapped ), so copy
+		void* res = allocate(new_bytes);
+		std::memcpy(res, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+		deallocate(ptr, old_bytes);
+		return res;
+	}
+
+	SSTD_INLINE huge_pages pages() const noexcept {
+		return m_pages;
+	}
+	SSTD_INLINE int node() const noexcept {
+		return m_node;
+	}
+private:
+	static SSTD_CONSTEXPR sizet _Huge_Page_Bytes = 2 * 1024 * 1024;
+
+	huge_pages m_pages;
+	int m_node;
+
+	static SSTD_INLINE SSTD_CONSTEXPR sizet _Map_Bytes(const sizet& bytes) noexcept {
+		return (bytes + _Huge_Page_Bytes - 1) & ~(_Huge_Page_Bytes - 1);
+	}
+
+#if defined(_WIN32)
+	SSTD_INLINE void* _Map(const sizet& bytes) const {
+		void* ptr = nullptr;
+		if (m_pages == huge_pages::reserved) {
+			ptr = _Virtual_Alloc(bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES);
+		}
+		// ( Windows has no transparent huge pages, so that's the normal pages )
+		if (ptr == nullptr) {
+			ptr = _Virtual_Alloc(bytes, MEM_RESERVE | MEM_COMMIT);
+		}
+		if (ptr == nullptr) {
+			throw std::bad_alloc();
+		}
+		return ptr;
+	}
+	SSTD_INLINE void* _Virtual_Alloc(const sizet& bytes, const DWORD& type) const noexcept {
+		if (m_node < 0) {
+			return VirtualAlloc(nullptr, bytes, type, PAGE_READWRITE);
+		}
+		return VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes, type, PAGE_READWRITE, static_cast<DWORD>(m_node));
+	}
+	static SSTD_INLINE void _Unmap(void* ptr, const sizet&) noexcept {
+		VirtualFree(ptr, 0, MEM_RELEASE);
+	}
+#else
+	SSTD_INLINE void* _Map(const sizet& bytes) const {
+#if defined(__linux__) && defined(MAP_HUGETLB)
+		if (m_pages == huge_pages::reserved) {
+			int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+			flags |= 21 << MAP_HUGE_SHIFT;
+#endif
+			void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+			if (ptr != MAP_FAILED) {
+				_Bind(ptr, bytes);
+				return ptr;
+			}
+		}
+#endif
+		void* ptr = _Map_Aligned(bytes);
+		_Prepare(ptr, bytes);
+		return ptr;
+	}
+
+	// A mapping that starts on a huge page boundary, otherwise its first and last few MiB can't be huge pages
+	static SSTD_INLINE void* _Map_Aligned(const sizet& bytes) {
+		void* ptr = mmap(nullptr, bytes + _Huge_Page_Bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED) {
+			throw std::bad_alloc();
+		}
+		// Cut off what's before the boundary and after the end
+		unsigned char* start = static_cast<unsigned char*>(ptr);
+		unsigned char* aligned = reinterpret_cast<unsigned char*>(_Map_Bytes(reinterpret_cast<std::uintptr_t>(start)));
+		if (aligned != start) {
+			munmap(start, static_cast<sizet>(aligned - start));
+		}
+		const sizet tail = _Huge_Page_Bytes - static_cast<sizet>(aligned - start);
+		if (tail) {
+			munmap(aligned + bytes, tail);
+		}
+		return aligned;
+	}
+
+	static SSTD_INLINE void _Unmap(void* ptr, const sizet& bytes) noexcept {
+		munmap(ptr, bytes);
+	}
+
+	// Page size hint and NUMA node of a fresh range ( nothing has been touched yet, so every page lands where it should )
+	SSTD_INLINE void _Prepare(void* ptr, const sizet& bytes) const noexcept {
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+		madvise(ptr, bytes, m_pages == huge_pages::none ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+#endif
+		_Bind(ptr, bytes);
+	}
+
+	// mbind straight through the syscall, so there's no libnuma to link
+	// ( Nodes past the bits of one long are ignored )
+	// Only a hint, if it fails the memory just goes wherever the kernel puts it
+	SSTD_INLINE void _Bind(void* ptr, const sizet& bytes) const noexcept {
+#if defined(__linux__) && defined(SYS_mbind)
+		if (m_node < 0 || m_node >= static_cast<int>(sizeof(unsigned long) * 8)) {
+			return;
+		}
+		// MPOL_BIND
+		const unsigned long mode = 2;
+		const unsigned long mask = 1ul << m_node;
+		syscall(SYS_mbind, ptr, bytes, mode, &mask, sizeof(mask) * 8 + 1, 0);
+#else
+		(void)ptr;
+		(void)bytes;
+#endif
+	}
+#endif
+
+#if defined(__linux__)
+	// Grow ( or shrink ) a mapping without copying, nullptr if the kernel won't
+	SSTD_INLINE void* _Remap(void* ptr, const sizet& old_bytes, const sizet& new_bytes) const {
+		if (old_bytes == new_bytes) {
+			return ptr;
+		}
+		// In place first, that works whenever the addresses after the mapping are free ( and always when shrinking )
+		void* res = mremap(ptr, old_bytes, new_bytes, 0);
+		if (res != MAP_FAILED) {
+			if (new_bytes > old_bytes) {
+				_Prepare(static_cast<unsigned char*>(ptr) + old_bytes, new_bytes - old_bytes);
+			}
+			return ptr;
+		}
+		// Otherwise move the page tables to a new aligned range ( replacing the placeholder mapping there )
+		void* target = _Map_Aligned(new_bytes);
+		res = mremap(ptr, old_bytes, new_bytes, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+		if (res == MAP_FAILED) {
+			munmap(target, new_bytes);
+			return nullptr;
+		}
+		_Prepare(res, new_bytes);
+		return res;
+	}
+#endif
+};
+
+SSTD_END
+
+#endif
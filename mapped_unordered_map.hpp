@@ -0,0 +1,212 @@
+#ifndef SSTD_MAPPED_UNORDERED_MAP_INCLUDED
+#define SSTD_MAPPED_UNORDERED_MAP_INCLUDED
+
+#include "core.hpp"
+#include "unordered_map.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SSTD_BEGIN
+
+// A whole file mapped read only into memory
+class _Mapped_File {
+public:
+	SSTD_EXPLICIT _Mapped_File(const char* path) {
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("Failed to open the unordered map snapshot");
+		}
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+			CloseHandle(file);
+			throw std::runtime_error("Invalid unordered map snapshot");
+		}
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping == nullptr) {
+			throw std::runtime_error("Failed to map the unordered map snapshot");
+		}
+		// The view keeps the mapping alive on its own
+		m_data = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		CloseHandle(mapping);
+		if (m_data == nullptr) {
+			throw std::runtime_error("Failed to map the unordered map snapshot");
+		}
+		m_size = static_cast<sizet>(file_size.QuadPart);
+#else
+		const int fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error("Failed to open the unordered map snapshot");
+		}
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0) {
+			close(fd);
+			throw std::runtime_error("Invalid unordered map snapshot");
+		}
+		void* data = mmap(nullptr, static_cast<sizet>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		// The mapping keeps the file alive on its own
+		close(fd);
+		if (data == MAP_FAILED) {
+			throw std::runtime_error("Failed to map the unordered map snapshot");
+		}
+		// Lookups jump all over the table, reading ahead is just wasted IO
+		madvise(data, static_cast<sizet>(info.st_size), MADV_RANDOM);
+		m_data = static_cast<unsigned char*>(data);
+		m_size = static_cast<sizet>(info.st_size);
+#endif
+	}
+
+	_Mapped_File(const _Mapped_File&) = delete;
+	_Mapped_File& operator=(const _Mapped_File&) = delete;
+
+	~_Mapped_File() {
+#if defined(_WIN32)
+		UnmapViewOfFile(m_data);
+#else
+		munmap(m_data, m_size);
+#endif
+	}
+
+	SSTD_INLINE unsigned char* data() const noexcept {
+		return m_data;
+	}
+	SSTD_INLINE sizet size() const noexcept {
+		return m_size;
+	}
+private:
+	unsigned char* m_data = nullptr;
+	sizet m_size = 0;
+};
+
+// A sstd::unordered_map served straight from a file written by unordered_map::save
+// Opening only maps the file and checks the header, so it costs the same no matter how big the map is,
+// after that every lookup just pays for the pages it touches ( the first time )
+// Lookups behave exactly like in the saved map, nothing can be modified
+//
+// The template arguments have to be the same as the ones of the saved map
+
+template<
+	typename _KeyT,	// Key type
+	typename _EltT,		// Element type
+	typename _Hash = hash<_KeyT>, // Hash function
+	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash>, // probing function
+	typename _Storage = _Inline_Storage<_KeyT, _EltT> // slot layout
+>
+class mapped_unordered_map {
+	static_assert(std::is_trivially_copyable<_KeyT>::value && std::is_trivially_copyable<_EltT>::value,
+		"Only maps with trivially copyable keys and elements can be mapped");
+	static_assert(_Storage::flat, "Only flat storages can be mapped");
+public:
+	using map_type = unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage>;
+	using const_iterator = typename map_type::const_iterator;
+
+	// Throws std::runtime_error if the file can't be mapped, or wasn't saved by the same kind of map
+	SSTD_EXPLICIT mapped_unordered_map(const char* path) :
+		m_file(path) {
+		if (m_file.size() < sizeof(_Map_Snapshot_Header)) {
+			throw std::runtime_error("Invalid unordered map snapshot");
+		}
+		_Map_Snapshot_Header header;
+		std::memcpy(&header, m_file.data(), sizeof(header));
+		const sizet capacity = static_cast<sizet>(header.capacity);
+		if (std::memcmp(header.magic, _Map_Snapshot_Header::Magic(), sizeof(header.magic)) != 0
+			|| header.version != _Map_Snapshot_Header::current_version
+			|| header.group_width != _ProbT::group_width
+			|| header.sizet_size != sizeof(sizet)
+			|| header.key_size != sizeof(_KeyT)
+			|| header.elt_size != sizeof(_EltT)
+			|| (capacity & (capacity - 1)) != 0
+			|| header.slot_bytes != _Storage::Bytes(capacity)
+			|| m_file.size() < _Map_Snapshot_Header::Slots_Offset(capacity) + _Storage::Bytes(capacity)) {
+			throw std::runtime_error("Invalid unordered map snapshot");
+		}
+
+		// Swap the table of the map for the mapped one
+		m_map.clear();
+		if (capacity) {
+			m_map.m_ctrl = reinterpret_cast<_Ctrl_T*>(m_file.data() + sizeof(_Map_Snapshot_Header));
+			m_map.m_slots.Attach(m_file.data() + _Map_Snapshot_Header::Slots_Offset(capacity), capacity);
+		}
+		m_map.m_capacity = capacity;
+		m_map.m_size = static_cast<sizet>(header.size);
+		m_map.m_tombstones = static_cast<sizet>(header.tombstones);
+		m_map.m_seed = header.seed;
+	}
+
+	mapped_unordered_map(const mapped_unordered_map&) = delete;
+	mapped_unordered_map& operator=(const mapped_unordered_map&) = delete;
+
+	~mapped_unordered_map() {
+		// The memory belongs to the file, don't let the map destruct or free it
+		m_map.m_ctrl = nullptr;
+		m_map.m_slots = _Storage();
+		m_map.m_capacity = 0;
+		m_map.m_size = 0;
+		m_map.m_tombstones = 0;
+	}
+
+	SSTD_INLINE const_iterator find(const _KeyT& key) const {
+		return m_map.find(key);
+	}
+	SSTD_INLINE bool contains(const _KeyT& key) const {
+		return m_map.contains(key);
+	}
+	SSTD_INLINE sizet count(const _KeyT& key) const {
+		return m_map.count(key);
+	}
+	// Throws if the key doesn't exist
+	SSTD_INLINE const _EltT& at(const _KeyT& key) const {
+		return m_map.at(key);
+	}
+	SSTD_INLINE void find_batch(const _KeyT* keys, const sizet& count, const _EltT** out) const {
+		m_map.find_batch(keys, count, out);
+	}
+
+	SSTD_INLINE sizet size() const noexcept {
+		return m_map.size();
+	}
+	SSTD_INLINE sizet capacity() const noexcept {
+		return m_map.capacity();
+	}
+	SSTD_INLINE bool empty() const noexcept {
+		return m_map.empty();
+	}
+
+	SSTD_INLINE hash_table_stats stats() const {
+		return m_map.stats();
+	}
+	SSTD_INLINE void dump_layout(std::ostream& out = std::cout) const {
+		m_map.dump_layout(out);
+	}
+
+	SSTD_INLINE const_iterator begin() const noexcept {
+		return m_map.begin();
+	}
+	SSTD_INLINE const_iterator end() const noexcept {
+		return m_map.end();
+	}
+private:
+	_Mapped_File m_file;
+	map_type m_map;
+};
+
+SSTD_END
+
+#endif
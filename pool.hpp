@@ -0,0 +1,140 @@
+#ifndef SSTD_POOL_INCLUDED
+#define SSTD_POOL_INCLUDED
+
+#include "core.hpp"
+#include "allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+SSTD_BEGIN
+
+// Hands out fixed size nodes, for node style containers ( lists, trees, node maps ... )
+// Freed nodes go on a free list and are the first ones handed out again, so allocating and freeing is a couple of pointer moves
+// New nodes are bumped out of blocks that come from the block cache ( see _Block_Cache ),
+// and nothing is given back before release() ( or the destructor )
+//
+// Not thread safe, use one pool per thread
+class pool {
+public:
+	// align has to be a power of 2
+	SSTD_EXPLICIT pool(const sizet& node_size, const sizet& align = alignof(std::max_align_t)) :
+		m_node_size(_Round_Up(node_size < sizeof(_Free_Node) ? sizeof(_Free_Node) : node_size, align)), m_align(align) {
+
+	}
+	pool(const pool&) = delete;
+	pool& operator=(const pool&) = delete;
+
+	~pool() {
+		release();
+	}
+
+	// Raw memory for one node
+	SSTD_INLINE void* allocate() {
+		if (m_free) {
+			_Free_Node* node = m_free;
+			m_free = node->next;
+			return node;
+		}
+		if (m_cur == nullptr || m_node_size > static_cast<sizet>(m_end - m_cur)) {
+			_New_Block();
+		}
+		void* node = m_cur;
+		m_cur += m_node_size;
+		return node;
+	}
+
+	SSTD_INLINE void deallocate(void* ptr) noexcept {
+		_Free_Node* node = static_cast<_Free_Node*>(ptr);
+		node->next = m_free;
+		m_free = node;
+	}
+
+	// Give every block back, every node handed out is gone
+	SSTD_INLINE void release() noexcept {
+		while (m_blocks) {
+			_Block* prev = m_blocks->prev;
+			_Block_Cache::Put(m_blocks, m_blocks->bytes);
+			m_blocks = prev;
+		}
+		m_free = nullptr;
+		m_cur = nullptr;
+		m_end = nullptr;
+	}
+
+	SSTD_INLINE sizet node_size() const noexcept {
+		return m_node_size;
+	}
+private:
+	struct _Free_Node {
+		_Free_Node* next;
+	};
+	// At the start of every block
+	struct alignas(std::max_align_t) _Block {
+		_Block* prev;
+		sizet bytes;
+	};
+
+	// A block holds at least this many nodes
+	static SSTD_CONSTEXPR sizet _Min_Nodes = 16;
+
+	const sizet m_node_size;
+	const sizet m_align;
+	_Free_Node* m_free = nullptr;
+	_Block* m_blocks = nullptr;
+	unsigned char* m_cur = nullptr;
+	unsigned char* m_end = nullptr;
+
+	static SSTD_INLINE SSTD_CONSTEXPR sizet _Round_Up(const sizet& n, const sizet& align) noexcept {
+		return (n + align - 1) & ~(align - 1);
+	}
+
+	SSTD_INLINE void _New_Block() {
+		const sizet needed = sizeof(_Block) + m_align + m_node_size * _Min_Nodes;
+		const sizet block_bytes = needed > _Block_Bytes ? needed : _Block_Bytes;
+		_Block* block = static_cast<_Block*>(_Block_Cache::Get(block_bytes));
+		block->prev = m_blocks;
+		block->bytes = block_bytes;
+		m_blocks = block;
+		const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(block + 1);
+		m_cur = reinterpret_cast<unsigned char*>(_Round_Up(start, m_align));
+		m_end = reinterpret_cast<unsigned char*>(block) + block_bytes;
+	}
+};
+
+// Lets a container allocate from a pool ( see allocator.hpp )
+// Requests of up to node_size bytes are served by the pool, bigger ones ( the slot arrays of a table for example ) by malloc
+// A node container ( node_unordered_map ) sees the node_size, and allocates every node that fits straight from the pool,
+// so size the pool for the nodes of the container
+// Just a pointer, so the pool has to outlive every container using it
+class pool_allocator {
+public:
+	pool_allocator(pool& _pool) noexcept :
+		m_pool(&_pool) {
+
+	}
+
+	SSTD_INLINE void* allocate(const sizet& bytes) {
+		if (bytes <= m_pool->node_size()) {
+			return m_pool->allocate();
+		}
+		return malloc_allocator().allocate(bytes);
+	}
+	SSTD_INLINE void deallocate(void* ptr, const sizet& bytes) noexcept {
+		if (bytes <= m_pool->node_size()) {
+			m_pool->deallocate(ptr);
+			return;
+		}
+		malloc_allocator().deallocate(ptr, bytes);
+	}
+
+	SSTD_INLINE sizet node_size() const noexcept {
+		return m_pool->node_size();
+	}
+private:
+	pool* m_pool;
+};
+
+SSTD_END
+
+#endif
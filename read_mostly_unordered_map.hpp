@@ -0,0 +1,446 @@
+#ifndef SSTD_READ_MOSTLY_UNORDERED_MAP_INCLUDED
+#define SSTD_READ_MOSTLY_UNORDERED_MAP_INCLUDED
+
+#include "core.hpp"
+#include "unordered_map.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+
+SSTD_BEGIN
+
+// -----------------------------------------
+//
+//   Epoch based reclamation
+//
+// -----------------------------------------
+
+// Every reading thread owns one record, which announces the epoch the thread started reading in
+// ( 0 means the thread isn't reading anything right now )
+struct alignas(64) _Epoch_Record {
+	std::atomic<uint64> active{ 0 };
+	std::atomic<bool> in_use{ false };
+	_Epoch_Record* next = nullptr;
+	// Nested read sections of the owning thread, only the outer one announces
+	uint32 depth = 0;
+};
+
+// Memory that got unlinked by a writer, and is freed once no reader can be holding it anymore
+struct _Retired {
+	void* ptr;
+	void (*deleter)(void*);
+	uint64 epoch;
+	_Retired* next;
+};
+
+// One global epoch shared by all the read mostly containers
+// A writer that unlinks something moves the epoch forward, and remembers the epoch it was unlinked in
+// It is safe to free once every reading thread has either stopped reading, or started reading in a later epoch
+class _Epoch_Domain {
+public:
+	static SSTD_INLINE _Epoch_Domain& Get() {
+		static _Epoch_Domain domain;
+		return domain;
+	}
+
+	~_Epoch_Domain() {
+		_Epoch_Record* rec = m_records.load(std::memory_order_acquire);
+		while (rec) {
+			_Epoch_Record* next = rec->next;
+			delete rec;
+			rec = next;
+		}
+	}
+
+	// The record of the calling thread ( handed back when the thread exits )
+	SSTD_INLINE _Epoch_Record& Record() {
+		struct _Owner {
+			_Epoch_Record* record;
+			_Owner() : record(_Epoch_Domain::Get()._Acquire()) {}
+			~_Owner() { record->in_use.store(false, std::memory_order_release); }
+		};
+		thread_local _Owner owner;
+		return *owner.record;
+	}
+
+	// Enter a read section
+	// The fence makes sure that either a writer scanning the records sees this announcement,
+	// or this thread sees everything the writer unlinked before scanning
+	SSTD_INLINE void Enter(_Epoch_Record& rec) {
+		if (rec.depth++ == 0) {
+			rec.active.store(m_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+		}
+	}
+	SSTD_INLINE void Leave(_Epoch_Record& rec) {
+		if (--rec.depth == 0) {
+			rec.active.store(0, std::memory_order_release);
+		}
+	}
+
+	// Call after unlinking, returns the epoch the unlinked memory belongs to
+	SSTD_INLINE uint64 Advance() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		return m_epoch.fetch_add(1, std::memory_order_acq_rel);
+	}
+
+	// Everything that was retired in an epoch below this is safe to free
+	SSTD_INLINE uint64 Safe_Epoch() const {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		uint64 res = m_epoch.load(std::memory_order_acquire);
+		for (_Epoch_Record* rec = m_records.load(std::memory_order_acquire); rec; rec = rec->next) {
+			const uint64 active = rec->active.load(std::memory_order_acquire);
+			if (active != 0 && active < res) {
+				res = active;
+			}
+		}
+		return res;
+	}
+private:
+	std::atomic<uint64> m_epoch{ 1 };
+	std::atomic<_Epoch_Record*> m_records{ nullptr };
+
+	_Epoch_Domain() SSTD_DEFAULT;
+
+	// Reuse the record of a thread that has exited, or push a new one
+	SSTD_INLINE _Epoch_Record* _Acquire() {
+		for (_Epoch_Record* rec = m_records.load(std::memory_order_acquire); rec; rec = rec->next) {
+			bool expected = false;
+			if (!rec->in_use.load(std::memory_order_relaxed) && rec->in_use.compare_exchange_strong(expected, true)) {
+				return rec;
+			}
+		}
+		_Epoch_Record* rec = new _Epoch_Record();
+		rec->in_use.store(true, std::memory_order_relaxed);
+		rec->next = m_records.load(std::memory_order_relaxed);
+		while (!m_records.compare_exchange_weak(rec->next, rec, std::memory_order_release, std::memory_order_relaxed)) {}
+		return rec;
+	}
+};
+
+// Keeps the current thread in a read section for its lifetime
+class _Epoch_Guard {
+public:
+	_Epoch_Guard() : m_record(_Epoch_Domain::Get().Record()) {
+		_Epoch_Domain::Get().Enter(m_record);
+	}
+	~_Epoch_Guard() {
+		_Epoch_Domain::Get().Leave(m_record);
+	}
+
+	_Epoch_Guard(const _Epoch_Guard&) = delete;
+	_Epoch_Guard& operator=(const _Epoch_Guard&) = delete;
+private:
+	_Epoch_Record& m_record;
+};
+
+// -----------------------------------------
+//
+//   Read mostly unordered map
+//
+// -----------------------------------------
+
+// An unordered_map for data that is read all the time, and only changed once in a while
+// Lookups never lock and never wait: they load the table, the control bytes and the elements atomically
+//
+// Every element lives in its own ( immutable ) _Map_Element, the table only holds pointers to them
+// A writer publishes a new element with an atomic store into the slot, and an overwrite swaps the pointer
+// The old elements ( and the old tables after a resize ) are only freed once no reader can be holding them ( see _Epoch_Domain )
+//
+// Writers are serialized with a mutex that readers never touch
+// Only scalar probing functors that never move an element after it got published are supported
+
+template<
+	typename _KeyT,	// Key type
+	typename _EltT,		// Element type
+	typename _Hash = hash<_KeyT>, // Hash function
+	typename _ProbT = _Linear_Prob<_KeyT, _Hash> // probing function
+>
+class read_mostly_unordered_map {
+	static_assert(_ProbT::group_width == 1 && !_ProbT::robin_hood, "read_mostly_unordered_map needs a scalar probing functor that never moves the elements");
+private:
+	using _Map_Element = sstd::_Map_Element<_KeyT, _EltT>;
+
+	// One generation of the table, replaced as a whole when it grows
+	struct _Table {
+		sizet capacity;
+		std::atomic<_Ctrl_T>* ctrl;
+		std::atomic<_Map_Element*>* slots;
+	};
+public:
+
+	// Default constructor
+	read_mostly_unordered_map() :
+		m_table(_Make_Table(8)) { // just some random magic number
+
+	}
+
+	~read_mostly_unordered_map() {
+		// No one can be reading anymore
+		_Table* table = m_table.load(std::memory_order_relaxed);
+		for (sizet i = 0; i < table->capacity; ++i) {
+			delete table->slots[i].load(std::memory_order_relaxed);
+		}
+		_Free_Table(table);
+		while (m_retired) {
+			_Retired* next = m_retired->next;
+			m_retired->deleter(m_retired->ptr);
+			delete m_retired;
+			m_retired = next;
+		}
+	}
+
+	read_mostly_unordered_map(const read_mostly_unordered_map&) = delete;
+	read_mostly_unordered_map& operator=(const read_mostly_unordered_map&) = delete;
+
+	// Copy the element into out if the key exists ( wait free )
+	SSTD_INLINE bool find(const _KeyT& key, _EltT& out) const {
+		return _Read(key, [&out](const _EltT& elt) { out = elt; });
+	}
+
+	// Call fn(elt) if the key exists, without copying it out ( wait free )
+	// The element stays alive until fn returns, even if a writer replaces it in the meantime
+	template<typename _Fn>
+	SSTD_INLINE bool visit(const _KeyT& key, _Fn&& fn) const {
+		return _Read(key, std::forward<_Fn>(fn));
+	}
+
+	SSTD_INLINE bool contains(const _KeyT& key) const {
+		return _Read(key, [](const _EltT&) {});
+	}
+
+	SSTD_INLINE sizet count(const _KeyT& key) const {
+		return contains(key);
+	}
+
+	// Insert the element, or replace it if the key already exists
+	// Returns whether the key is new
+	template<typename _KeyArg, typename _TE>
+	SSTD_INLINE bool insert(_KeyArg&& key, _TE&& elt) {
+		return _Write(true, std::forward<_KeyArg>(key), std::forward<_TE>(elt));
+	}
+
+	template<typename _KeyArg, typename _TE>
+	SSTD_INLINE bool insert_or_assign(_KeyArg&& key, _TE&& elt) {
+		return _Write(true, std::forward<_KeyArg>(key), std::forward<_TE>(elt));
+	}
+
+	// Construct the element only if the key doesn't exist yet
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE bool try_emplace(_KeyArg&& key, _Args&& ...args) {
+		return _Write(false, std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+	}
+
+	// Returns how many elements got erased ( 0 or 1 )
+	SSTD_INLINE sizet erase(const _KeyT& key) {
+		std::lock_guard<std::mutex> lock(m_writer);
+		_Table* table = m_table.load(std::memory_order_relaxed);
+		const sizet ind = _Find_Index(table, key, _Hash_Key(key));
+		if (ind == table->capacity) {
+			return 0;
+		}
+		// Readers that already loaded the pointer still get to use it till they're done
+		table->ctrl[ind].store(_Ctrl_Deleted, std::memory_order_release);
+		_Map_Element* old = table->slots[ind].exchange(nullptr, std::memory_order_acq_rel);
+		m_size.fetch_sub(1, std::memory_order_relaxed);
+		++m_tombstones;
+		_Retire(old, &_Delete_Element);
+		return 1;
+	}
+
+	// Grow the table, so that _size elements fit in without growing again
+	SSTD_INLINE void reserve(const sizet& _size) {
+		std::lock_guard<std::mutex> lock(m_writer);
+		const sizet needed = static_cast<sizet>(_size / _ProbT::max_load_factor) + 1;
+		if (needed > m_table.load(std::memory_order_relaxed)->capacity) {
+			_Rehash(needed);
+		}
+	}
+
+	SSTD_INLINE sizet size() const noexcept {
+		return m_size.load(std::memory_order_relaxed);
+	}
+	SSTD_INLINE bool empty() const noexcept {
+		return size() == 0;
+	}
+	SSTD_INLINE sizet capacity() const noexcept {
+		return m_table.load(std::memory_order_relaxed)->capacity;
+	}
+private:
+	std::atomic<_Table*> m_table;
+	std::atomic<sizet> m_size{ 0 };
+
+	// Only touched by the writer holding m_writer
+	std::mutex m_writer;
+	sizet m_tombstones = 0;
+	_Retired* m_retired = nullptr;
+
+	const _Hash m_Hasher{};
+	const _ProbT m_prob{};
+	// Never changes, so the readers don't need to care about it
+	const uint64 m_seed = _Random_Seed();
+
+	SSTD_INLINE sizet _Hash_Key(const _KeyT& key) const {
+		return _Table_Hash(m_Hasher, key, m_seed);
+	}
+
+	SSTD_INLINE static _Table* _Make_Table(const sizet& memsize) {
+		_Table* table = new _Table();
+		table->capacity = _Round_Up_Power_Of_2(memsize);
+		table->ctrl = (std::atomic<_Ctrl_T>*)malloc(sizeof(std::atomic<_Ctrl_T>) * table->capacity);
+		table->slots = (std::atomic<_Map_Element*>*)malloc(sizeof(std::atomic<_Map_Element*>) * table->capacity);
+		for (sizet i = 0; i < table->capacity; ++i) {
+			new (&table->ctrl[i]) std::atomic<_Ctrl_T>(_Ctrl_Empty);
+			new (&table->slots[i]) std::atomic<_Map_Element*>(nullptr);
+		}
+		return table;
+	}
+
+	// Only frees the table itself, not the elements ( they might have moved on to a newer table )
+	SSTD_INLINE static void _Free_Table(void* ptr) {
+		_Table* table = static_cast<_Table*>(ptr);
+		free(table->ctrl);
+		free(table->slots);
+		delete table;
+	}
+
+	SSTD_INLINE static void _Delete_Element(void* ptr) {
+		delete static_cast<_Map_Element*>(ptr);
+	}
+
+	// The reading side, never locks and never loops more than capacity times
+	template<typename _Fn>
+	SSTD_INLINE bool _Read(const _KeyT& key, _Fn&& fn) const {
+		const sizet hash = _Hash_Key(key);
+		const _Ctrl_T fragment = _Hash_Fragment(hash);
+
+		_Epoch_Guard guard;
+		const _Table* table = m_table.load(std::memory_order_acquire);
+		for (sizet i = 0; i != table->capacity; ++i) {
+			const sizet ind = m_prob(hash, i, table->capacity - 1);
+			const _Ctrl_T ctrl = table->ctrl[ind].load(std::memory_order_acquire);
+			if (ctrl == _Ctrl_Empty) {
+				return false;
+			}
+			if (ctrl == fragment) {
+				const _Map_Element* elt = table->slots[ind].load(std::memory_order_acquire);
+				// Can be null if it just got erased
+				if (elt && elt->hash == hash && elt->key == key) {
+					fn(elt->elt);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Writer side lookup ( m_writer is held, so nothing changes under it )
+	SSTD_INLINE sizet _Find_Index(const _Table* table, const _KeyT& key, const sizet& hash) const {
+		const _Ctrl_T fragment = _Hash_Fragment(hash);
+		for (sizet i = 0; i != table->capacity; ++i) {
+			const sizet ind = m_prob(hash, i, table->capacity - 1);
+			const _Ctrl_T ctrl = table->ctrl[ind].load(std::memory_order_relaxed);
+			if (ctrl == _Ctrl_Empty) {
+				return table->capacity;
+			}
+			if (ctrl == fragment) {
+				const _Map_Element* elt = table->slots[ind].load(std::memory_order_relaxed);
+				if (elt->hash == hash && elt->key == key) {
+					return ind;
+				}
+			}
+		}
+		return table->capacity;
+	}
+
+	// The first empty ( or deleted ) slot on the probing sequence of hash
+	SSTD_INLINE sizet _Find_Free_Index(const _Table* table, const sizet& hash) const {
+		for (sizet i = 0; i != table->capacity; ++i) {
+			const sizet ind = m_prob(hash, i, table->capacity - 1);
+			if (!_Is_Full(table->ctrl[ind].load(std::memory_order_relaxed))) {
+				return ind;
+			}
+		}
+		return table->capacity;
+	}
+
+	// Publish the element into a free slot
+	// The pointer is stored before the control byte, so a reader that sees the fragment also sees the element
+	SSTD_INLINE static void _Publish(_Table* table, const sizet& ind, _Map_Element* elt) {
+		table->slots[ind].store(elt, std::memory_order_release);
+		table->ctrl[ind].store(_Hash_Fragment(elt->hash), std::memory_order_release);
+	}
+
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE bool _Write(const bool assign, _KeyArg&& key, _Args&& ...args) {
+		std::lock_guard<std::mutex> lock(m_writer);
+		const sizet hash = _Hash_Key(key);
+		_Table* table = m_table.load(std::memory_order_relaxed);
+
+		const sizet found = _Find_Index(table, key, hash);
+		if (found != table->capacity) {
+			if (assign) {
+				// Readers either get the old element or the new one, never a half written one
+				_Map_Element* elt = new _Map_Element{ std::forward<_KeyArg>(key), _EltT(std::forward<_Args>(args)...), hash };
+				_Retire(table->slots[found].exchange(elt, std::memory_order_acq_rel), &_Delete_Element);
+			}
+			return false;
+		}
+
+		// Mantain the used slots below the max_load_factor
+		// ( Rebuilding at the same capacity is enough if most of them are deleted slots )
+		if (static_cast<Decimal>(size() + m_tombstones + 1) > table->capacity * _ProbT::max_load_factor) {
+			_Rehash(size() + 1 > table->capacity * _ProbT::max_load_factor / 2 ? table->capacity * 2 : table->capacity);
+			table = m_table.load(std::memory_order_relaxed);
+		}
+
+		const sizet ind = _Find_Free_Index(table, hash);
+		if (table->ctrl[ind].load(std::memory_order_relaxed) == _Ctrl_Deleted) {
+			--m_tombstones;
+		}
+		_Publish(table, ind, new _Map_Element{ std::forward<_KeyArg>(key), _EltT(std::forward<_Args>(args)...), hash });
+		m_size.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Build a new table with the same elements ( only the pointers are copied ), publish it, and retire the old one
+	SSTD_INLINE void _Rehash(const sizet& memsize) {
+		_Table* old_table = m_table.load(std::memory_order_relaxed);
+		_Table* table = _Make_Table(memsize);
+		for (sizet i = 0; i < old_table->capacity; ++i) {
+			_Map_Element* elt = old_table->slots[i].load(std::memory_order_relaxed);
+			if (elt) {
+				_Publish(table, _Find_Free_Index(table, elt->hash), elt);
+			}
+		}
+		m_table.store(table, std::memory_order_release);
+		m_tombstones = 0;
+		_Retire(old_table, &_Free_Table);
+	}
+
+	// Free ptr once no reader can be holding it anymore
+	SSTD_INLINE void _Retire(void* ptr, void (*deleter)(void*)) {
+		_Epoch_Domain& domain = _Epoch_Domain::Get();
+		m_retired = new _Retired{ ptr, deleter, domain.Advance(), m_retired };
+
+		const uint64 safe = domain.Safe_Epoch();
+		_Retired** link = &m_retired;
+		while (*link) {
+			_Retired* cur = *link;
+			if (cur->epoch < safe) {
+				*link = cur->next;
+				cur->deleter(cur->ptr);
+				delete cur;
+			}
+			else {
+				link = &cur->next;
+			}
+		}
+	}
+};
+
+SSTD_END
+
+#endif
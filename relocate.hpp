@@ -0,0 +1,69 @@
+#ifndef SSTD_RELOCATE_INCLUDED
+#define SSTD_RELOCATE_INCLUDED
+
+#include "core.hpp"
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+SSTD_BEGIN
+
+// Relocating an object = moving it to new memory and destroying the old one, in one step
+//
+// For most types that's the same as copying the bytes and forgetting about the old ones,
+// so the containers can grow with realloc and shift elements with memmove
+// But a type that points into itself ( or is pointed to by something else ) breaks if its bytes move,
+// those have to be move constructed into the new memory and destroyed in the old one
+//
+// is_trivially_relocatable picks between the 2
+// Trivially copyable types are detected, anything else has to opt in by specializing it:
+//
+//   template<>
+//   struct sstd::is_trivially_relocatable<my_type> : std::true_type {};
+//
+// Only do that if nothing points into the object, libstdc++'s std::string for example
+// points into its own small buffer, so it must NOT be marked
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+// A unique pointer is a plain pointer ( the default deleter is empty )
+template<typename T>
+struct is_trivially_relocatable<std::unique_ptr<T> > : std::true_type {};
+
+// Move n objects from src to dst ( the ranges can overlap ), src ends up raw memory
+template<typename T>
+SSTD_INLINE void _Relocate_Range(T* dst, T* src, const sizet& n) {
+	if (n == 0 || dst == src) {
+		return;
+	}
+	if constexpr (is_trivially_relocatable<T>::value) {
+		std::memmove(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+	}
+	else if (dst < src) {
+		for (sizet i = 0; i < n; ++i) {
+			new (dst + i) T(std::move(src[i]));
+			src[i].~T();
+		}
+	}
+	else {
+		for (sizet i = n; i-- > 0;) {
+			new (dst + i) T(std::move(src[i]));
+			src[i].~T();
+		}
+	}
+}
+
+template<typename T>
+SSTD_INLINE void _Destroy_Range(T* ptr, const sizet& n) noexcept {
+	if constexpr (!std::is_trivially_destructible<T>::value) {
+		for (sizet i = 0; i < n; ++i) {
+			ptr[i].~T();
+		}
+	}
+}
+
+SSTD_END
+
+#endif
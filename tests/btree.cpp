@@ -0,0 +1,304 @@
+// sstd::btree_map and sstd::btree_set against std::map and std::set, build and run it twice:
+//
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -I.. btree.cpp -o btree_test && ./btree_test
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -march=native -I.. btree.cpp -o btree_test && ./btree_test
+//
+// Integer keys search their nodes by counting with SIMD compares ( see _Count_Keys ), SSE2 on a plain x86-64 build
+// and AVX2 with -march=native, everything else ( strings, std::greater ) goes through the binary search
+//
+// Every key type runs ascending inserts ( the append path ), descending inserts, a sliding window, and a random mix,
+// each compared in both directions of iteration and with lower_bound / upper_bound around every key,
+// and then erased down to empty ( which merges the nodes back together )
+
+#include "check.hpp"
+#include "btree_map.hpp"
+#include "btree_set.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using sstd::sizet;
+using sstd::uint64;
+
+// Key number i, in the order of i
+// The unsigned ones cross the top bit, where the SIMD compares need to flip it
+template<typename _KeyT>
+static _KeyT _Key(const uint64& i) {
+	if constexpr (std::is_same<_KeyT, std::string>::value) {
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "key_%010llu", static_cast<unsigned long long>(i));
+		return buf;
+	}
+	else if constexpr (std::is_signed<_KeyT>::value) {
+		return static_cast<_KeyT>(static_cast<sstd::int64>(i) - std::numeric_limits<_KeyT>::max() / 4);
+	}
+	else {
+		return static_cast<_KeyT>(std::numeric_limits<_KeyT>::max() / 2 - 50000 + i);
+	}
+}
+
+static std::string _Value(const uint64& version) {
+	// Longer than the small string buffer, so a lost or doubled element shows up
+	return std::to_string(version) + std::string(24, 'v');
+}
+
+// The key at an iterator of any of the 4 containers
+template<typename _KeyT, typename _EltT>
+static const _KeyT& _Key_Of(const std::pair<const _KeyT, _EltT>& kv) {
+	return kv.first;
+}
+template<typename _KeyT, typename _EltT>
+static const _KeyT& _Key_Of(const std::pair<const _KeyT&, const _EltT&>& kv) {
+	return kv.first;
+}
+template<typename _KeyT>
+static const _KeyT& _Key_Of(const _KeyT& key) {
+	return key;
+}
+
+// Both point to the same key, or are both at the end
+template<typename _Iter, typename _RefIter>
+static bool _Same_Pos(const _Iter& it, const _Iter& end, const _RefIter& ref, const _RefIter& ref_end) {
+	if (it == end || ref == ref_end) {
+		return it == end && ref == ref_end;
+	}
+	return _Key_Of(*it) == _Key_Of(*ref);
+}
+
+// lower_bound / upper_bound of probe, and one step back from each ( across a leaf link now and then )
+template<typename _Tree, typename _Ref, typename _KeyT>
+static void _Check_Bounds(const _Tree& tree, const _Ref& ref, const _KeyT& probe) {
+	typename _Tree::const_iterator lower = tree.lower_bound(probe);
+	typename _Ref::const_iterator ref_lower = ref.lower_bound(probe);
+	SSTD_CHECK(_Same_Pos(lower, tree.end(), ref_lower, ref.end()));
+	if (ref_lower != ref.begin()) {
+		SSTD_CHECK(_Key_Of(*--lower) == _Key_Of(*--ref_lower));
+	}
+	typename _Tree::const_iterator upper = tree.upper_bound(probe);
+	typename _Ref::const_iterator ref_upper = ref.upper_bound(probe);
+	SSTD_CHECK(_Same_Pos(upper, tree.end(), ref_upper, ref.end()));
+	if (ref_upper != ref.begin()) {
+		SSTD_CHECK(_Key_Of(*--upper) == _Key_Of(*--ref_upper));
+	}
+}
+
+// Walk the whole tree forwards, and back again from end()
+template<typename _Tree, typename _Ref>
+static void _Check_Order(const _Tree& tree, const _Ref& ref) {
+	SSTD_CHECK(tree.size() == ref.size() && tree.empty() == ref.empty());
+	typename _Tree::const_iterator it = tree.begin();
+	for (typename _Ref::const_iterator r = ref.begin(); r != ref.end(); ++r, ++it) {
+		SSTD_CHECK(it != tree.end() && _Key_Of(*it) == _Key_Of(*r));
+	}
+	SSTD_CHECK(it == tree.end());
+	for (typename _Ref::const_reverse_iterator r = ref.rbegin(); r != ref.rend(); ++r) {
+		--it;
+		SSTD_CHECK(_Key_Of(*it) == _Key_Of(*r));
+	}
+	SSTD_CHECK(it == tree.begin());
+}
+
+// The 2 trees and what they should hold, fed the same operations
+template<typename _KeyT, typename _Compare>
+struct _Trees {
+	sstd::btree_map<_KeyT, std::string, _Compare> map;
+	sstd::btree_set<_KeyT, _Compare> set;
+	std::map<_KeyT, std::string, _Compare> ref_map;
+	std::set<_KeyT, _Compare> ref_set;
+
+	void Insert(const uint64& i, const uint64& version) {
+		const _KeyT key = _Key<_KeyT>(i);
+		const std::string value = _Value(version);
+		// Every way in
+		switch (version % 3) {
+		case 0: {
+			const bool inserted = map.insert_or_assign(key, value).second;
+			SSTD_CHECK(inserted == (ref_map.count(key) == 0));
+			ref_map[key] = value;
+			break;
+		}
+		case 1: {
+			const auto res = map.emplace(key, value);
+			const auto ref_res = ref_map.emplace(key, value);
+			SSTD_CHECK(res.second == ref_res.second);
+			SSTD_CHECK(res.first->first == key && res.first->second == ref_res.first->second);
+			break;
+		}
+		default:
+			map[key] = value;
+			ref_map[key] = value;
+		}
+		const auto res = set.insert(key);
+		SSTD_CHECK(res.second == ref_set.insert(key).second && *res.first == key);
+	}
+
+	void Erase(const uint64& i) {
+		const _KeyT key = _Key<_KeyT>(i);
+		SSTD_CHECK(map.erase(key) == ref_map.erase(key));
+		SSTD_CHECK(set.erase(key) == ref_set.erase(key));
+	}
+
+	// Everything in order, and the lookups and bounds of every key number up to last ( the ones in the trees and the ones in between )
+	void Check(const uint64& last) const {
+		_Check_Order(map, ref_map);
+		_Check_Order(set, ref_set);
+		for (uint64 i = 0; i <= last; ++i) {
+			const _KeyT key = _Key<_KeyT>(i);
+			const auto found = ref_map.find(key);
+			SSTD_CHECK(map.contains(key) == (found != ref_map.end()) && set.contains(key) == (found != ref_map.end()));
+			if (found != ref_map.end()) {
+				SSTD_CHECK(map.at(key) == found->second && map.find(key)->second == found->second && *set.find(key) == key);
+			}
+			else {
+				SSTD_CHECK(map.find(key) == map.end() && set.find(key) == set.end());
+			}
+			_Check_Bounds(map, ref_map, key);
+			_Check_Bounds(set, ref_set, key);
+		}
+	}
+
+	// Erase what's left in a random order, down to an empty tree that still works
+	void Erase_All(std::mt19937_64& rng, const uint64& last) {
+		std::vector<uint64> order;
+		for (uint64 i = 0; i <= last; ++i) {
+			if (ref_set.count(_Key<_KeyT>(i))) {
+				order.push_back(i);
+			}
+		}
+		std::shuffle(order.begin(), order.end(), rng);
+		for (sizet n = 0; n < order.size(); ++n) {
+			Erase(order[n]);
+			// A few times on the way down
+			if (n % (order.size() / 4 + 1) == order.size() / 8) {
+				Check(last);
+			}
+		}
+		SSTD_CHECK(map.empty() && set.empty());
+		SSTD_CHECK(map.height() == 0 && set.height() == 0);
+		SSTD_CHECK(map.begin() == map.end() && set.begin() == set.end());
+		SSTD_CHECK(map.lower_bound(_Key<_KeyT>(1)) == map.end() && set.upper_bound(_Key<_KeyT>(1)) == set.end());
+		Insert(1, 1);
+		Check(2);
+		Erase(1);
+	}
+};
+
+template<typename _KeyT, typename _Compare = std::less<_KeyT> >
+static void _Test_Keys(const char* name) {
+	std::printf("  %s\n", name);
+	std::mt19937_64 rng(42);
+	const sizet keys = sstd::_BTree_Node_Keys(sizeof(_KeyT));
+	// Whether ascending key numbers are ascending keys for _Compare, so they go through the append path
+	const bool appends = _Compare()(_Key<_KeyT>(1), _Key<_KeyT>(2));
+
+	// Ascending, a full leaf gets a new leaf after it instead of being split in half
+	// keys full leaves fit under a single root, half full ones wouldn't
+	{
+		_Trees<_KeyT, _Compare> trees;
+		const uint64 count = keys * keys;
+		for (uint64 i = 1; i <= count; ++i) {
+			trees.Insert(i, i);
+		}
+		if (appends) {
+			SSTD_CHECK(trees.map.height() == 2 && trees.set.height() == 2);
+		}
+		trees.Check(count + 1);
+		// The appended leaves are full, the last one isn't, erasing rebalances around both
+		trees.Erase_All(rng, count + 1);
+	}
+
+	// Descending
+	{
+		_Trees<_KeyT, _Compare> trees;
+		const uint64 count = 3 * keys * keys;
+		for (uint64 i = count; i >= 1; --i) {
+			trees.Insert(i, i);
+		}
+		trees.Check(count + 1);
+		// The smallest half, then the rest
+		for (uint64 i = 1; i <= count / 2; ++i) {
+			trees.Erase(i);
+		}
+		trees.Check(count + 1);
+		trees.Erase_All(rng, count + 1);
+	}
+
+	// A sliding window, new keys at the end and the oldest ones erased from the front
+	{
+		_Trees<_KeyT, _Compare> trees;
+		const uint64 window = 2 * keys * keys;
+		const uint64 count = 4 * window;
+		for (uint64 i = 1; i <= count; ++i) {
+			trees.Insert(i, i);
+			if (i > window) {
+				trees.Erase(i - window);
+			}
+			if (i % window == 0) {
+				trees.Check(count + 1);
+			}
+		}
+		trees.Erase_All(rng, count + 1);
+	}
+
+	// Random inserts, overwrites and erases, the node splits and merges happen all over the tree
+	{
+		_Trees<_KeyT, _Compare> trees;
+		const uint64 range = 20000;
+		for (uint64 op = 1; op <= 100000; ++op) {
+			const uint64 i = 1 + rng() % range;
+			// Mostly inserts in the first half, mostly erases in the second one
+			if (rng() % 100 < (op <= 50000 ? 65u : 35u)) {
+				trees.Insert(i, op);
+			}
+			else {
+				trees.Erase(i);
+			}
+			if (op % 25000 == 0) {
+				trees.Check(range + 1);
+			}
+		}
+		trees.Erase_All(rng, range + 1);
+	}
+}
+
+int main() {
+#if defined(SSTD_HAS_AVX2)
+	std::printf("node search: AVX2\n");
+#elif defined(SSTD_HAS_SSE2)
+	std::printf("node search: SSE2\n");
+#else
+	std::printf("node search: scalar\n");
+#endif
+	static_assert(sstd::_Is_Counted_Search<int, std::less<int> >::value, "int keys get counted");
+	static_assert(!sstd::_Is_Counted_Search<int, std::greater<int> >::value, "other orders get bisected");
+
+	_Test_Keys<int>("int");
+	_Test_Keys<sstd::uint32>("uint32");
+	_Test_Keys<sstd::int64>("int64");
+	_Test_Keys<sstd::uint64>("uint64");
+	_Test_Keys<short>("short");
+	_Test_Keys<int, std::greater<int> >("int, std::greater");
+	_Test_Keys<std::string>("std::string");
+
+	// it->first and it->second go through a proxy
+	{
+		sstd::btree_map<int, std::string> map = { { 1, "a" }, { 2, "b" } };
+		for (sstd::btree_map<int, std::string>::iterator it = map.begin(); it != map.end(); ++it) {
+			it->second += std::to_string(it->first);
+		}
+		SSTD_CHECK(map.at(1) == "a1" && map.at(2) == "b2");
+		const sstd::btree_map<int, std::string>& view = map;
+		SSTD_CHECK(view.find(2)->second == "b2" && &view.begin()->first == &view.begin().key());
+	}
+
+	std::printf("btree ok\n");
+	return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef SSTD_TESTS_CHECK_INCLUDED
+#define SSTD_TESTS_CHECK_INCLUDED
+
+// Every test is a single file with its own main, build and run one with
+//
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -I.. vector.cpp -o vector_test && ./vector_test
+//
+// ( concurrent ones with -fsanitize=thread -pthread instead )
+// A test prints what failed and returns 1, so a script can run them all
+
+#include <cstdio>
+#include <cstdlib>
+
+// Unlike assert this stays on with NDEBUG
+#define SSTD_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			std::exit(1); \
+		} \
+	} while (0)
+
+#endif
@@ -0,0 +1,170 @@
+// 8 threads hammering one concurrent_unordered_map, meant to run under thread sanitizer:
+//
+//   g++ -std=c++17 -O1 -g -fsanitize=thread -pthread -I.. concurrent_unordered_map.cpp -o concurrent_test && ./concurrent_test
+//
+// Every thread owns the keys with key % _Threads == its id, and inserts / erases / overwrites only those,
+// so it knows exactly what has to be in the map for them at the end
+// On top of that every thread reads the keys of all the others ( a value found has to belong to its key ),
+// bumps a few shared counter keys with upsert, and now and then walks the whole map
+
+#include "check.hpp"
+#include "concurrent_unordered_map.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using key_type = sstd::uint64;
+
+// Small enough to make the shards grow ( and rehash ) a few times while the threads run
+static const unsigned _Threads = 8;
+static const key_type _Keys_Per_Thread = 4096;
+static const unsigned _Ops = 40000;
+static const key_type _Counters = 4;
+// The counter keys are past every owned key
+static const key_type _Counter_Base = _Keys_Per_Thread * _Threads;
+
+// The element of a key always encodes the key, so a reader can tell a torn or misplaced element apart
+static key_type _Value(const key_type& key, const key_type& version) {
+	return key << 20 | version;
+}
+
+struct _Rng {
+	sstd::uint64 state;
+
+	sstd::uint64 operator()() noexcept {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+};
+
+using map_type = sstd::concurrent_unordered_map<key_type, key_type, sstd::hash<key_type>, sstd::_Double_Hash_Prob<key_type, sstd::hash<key_type> >, 16>;
+
+// expected[k] is the value of the k-th owned key, 0 if it's not in the map
+static void _Worker(map_type& map, const unsigned id, std::vector<key_type>& expected, std::atomic<bool>& go) {
+	_Rng rng{ 0x9E3779B97F4A7C15ull * (id + 1) };
+	while (!go.load(std::memory_order_acquire)) {
+		std::this_thread::yield();
+	}
+	for (unsigned i = 0; i < _Ops; ++i) {
+		const sstd::uint64 r = rng();
+		const key_type k = (r >> 8) % _Keys_Per_Thread;
+		const key_type key = k * _Threads + id;
+		key_type out;
+		switch (r % 16) {
+		case 0: case 1: case 2: {
+			const key_type value = _Value(key, i + 1);
+			SSTD_CHECK(map.insert(key, value) == (expected[k] == 0));
+			expected[k] = value;
+			break;
+		}
+		case 3: case 4:
+			SSTD_CHECK(map.erase(key) == (expected[k] != 0));
+			expected[k] = 0;
+			break;
+		case 5:
+			SSTD_CHECK(map.try_emplace(key, _Value(key, i + 1)) == (expected[k] == 0));
+			if (expected[k] == 0) {
+				expected[k] = _Value(key, i + 1);
+			}
+			break;
+		case 6: {
+			// Read-modify-write, the version part goes up by one
+			const bool fresh = map.upsert(key, [](key_type& elt) { ++elt; }, _Value(key, 0));
+			SSTD_CHECK(fresh == (expected[k] == 0));
+			expected[k] = fresh ? _Value(key, 1) : expected[k] + 1;
+			break;
+		}
+		case 7:
+			map.upsert(_Counter_Base + (r >> 40) % _Counters, [](key_type& elt) { ++elt; }, 0);
+			break;
+		case 8:
+			if (i % 64 == 8) {
+				// The whole map under every lock, each element still belongs to its key
+				map.for_each([](const key_type& key, const key_type& elt) {
+					if (key < _Counter_Base) {
+						SSTD_CHECK(elt >> 20 == key);
+					}
+				});
+				break;
+			}
+			// Fall through to a read
+			[[fallthrough]];
+		default: {
+			// Someone else's key ( or our own )
+			const key_type other = (r >> 32) % _Counter_Base;
+			if (map.find(other, out)) {
+				SSTD_CHECK(out >> 20 == other);
+			}
+			if (other % _Threads == id) {
+				SSTD_CHECK(map.contains(other) == (expected[other / _Threads] != 0));
+			}
+			break;
+		}
+		}
+	}
+}
+
+int main() {
+	map_type map;
+	std::vector<std::vector<key_type> > expected(_Threads, std::vector<key_type>(_Keys_Per_Thread, 0));
+	std::atomic<bool> go(false);
+
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < _Threads; ++t) {
+		pool.emplace_back(_Worker, std::ref(map), t, std::ref(expected[t]), std::ref(go));
+	}
+	go.store(true, std::memory_order_release);
+	for (std::thread& thread : pool) {
+		thread.join();
+	}
+
+	// Every owned key is exactly where its owner left it
+	sstd::sizet live = 0;
+	for (unsigned t = 0; t < _Threads; ++t) {
+		for (key_type k = 0; k < _Keys_Per_Thread; ++k) {
+			const key_type key = k * _Threads + t;
+			key_type out = 0;
+			const bool found = map.find(key, out);
+			SSTD_CHECK(found == (expected[t][k] != 0));
+			if (found) {
+				SSTD_CHECK(out == expected[t][k]);
+				++live;
+			}
+		}
+	}
+
+	// No counter bump got lost
+	key_type bumps = 0;
+	key_type counters = 0;
+	for (key_type c = 0; c < _Counters; ++c) {
+		key_type out = 0;
+		if (map.find(_Counter_Base + c, out)) {
+			bumps += out;
+			++counters;
+		}
+	}
+	// Every thread draws the same sequence with its own seed, so count the bumps the same way
+	key_type expected_bumps = 0;
+	for (unsigned t = 0; t < _Threads; ++t) {
+		_Rng rng{ 0x9E3779B97F4A7C15ull * (t + 1) };
+		for (unsigned i = 0; i < _Ops; ++i) {
+			expected_bumps += rng() % 16 == 7;
+		}
+	}
+	SSTD_CHECK(bumps == expected_bumps);
+
+	SSTD_CHECK(map.size() == live + counters);
+	sstd::sizet walked = 0;
+	map.for_each([&](const key_type&, const key_type&) {
+		++walked;
+	});
+	SSTD_CHECK(walked == live + counters);
+
+	map.clear();
+	SSTD_CHECK(map.empty());
+	std::printf("concurrent_unordered_map: ok\n");
+	return 0;
+}
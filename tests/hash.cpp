@@ -0,0 +1,240 @@
+// Quality of the sstd::hash functions
+// Avalanche: flipping one input ( or seed ) bit has to flip every output bit with a probability of about 1/2
+// Collisions: realistic key sets ( sequential integers, strided integers, numbered strings, long strings that
+// differ in a single byte ... ) must not collide on the full 64 bits, and must spread evenly over the bits the tables use
+//
+// Byte strings are checked at every length class, the short wyhash style path as well as the long accumulator
+// ( SIMD when available, see hash.hpp ), and across the boundary between the two
+
+#include "check.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using sstd::uint8;
+using sstd::uint64;
+using sstd::sizet;
+
+// Flip statistics of a series of ( hash, hash with one bit flipped ) pairs
+struct _Avalanche {
+	uint64 flips[64] = {};
+	uint64 pairs = 0;
+
+	void Add(const uint64& a, const uint64& b) {
+		const uint64 diff = a ^ b;
+		for (int i = 0; i < 64; ++i) {
+			flips[i] += (diff >> i) & 1;
+		}
+		++pairs;
+	}
+
+	// Every output bit flips with a probability within 1/2 +- bias
+	void Check(const char* name, const double& bias) const {
+		double lowest = 1;
+		double highest = 0;
+		double total = 0;
+		for (int i = 0; i < 64; ++i) {
+			const double p = static_cast<double>(flips[i]) / pairs;
+			lowest = std::min(lowest, p);
+			highest = std::max(highest, p);
+			total += p;
+		}
+		std::printf("  %-28s %6.3f bits flipped, per bit [%.3f, %.3f]\n", name, total, lowest, highest);
+		SSTD_CHECK(lowest > 0.5 - bias && highest < 0.5 + bias);
+	}
+};
+
+static void _Bytes_Avalanche(std::mt19937_64& rng, const sizet& len) {
+	std::vector<uint8> buf(len + 1);
+	_Avalanche res;
+	// Long inputs get a sample of their bits, so every length costs about the same
+	const sizet bits = len * 8 + 64;
+	const sizet tries = std::min<sizet>(bits, 512);
+	for (int sample = 0; sample < 100; ++sample) {
+		for (uint8& b : buf) {
+			b = static_cast<uint8>(rng());
+		}
+		const uint64 seed = rng();
+		const uint64 hash = sstd::hash_bytes(buf.data(), len, seed);
+		for (sizet t = 0; t < tries; ++t) {
+			const sizet bit = bits == tries ? t : rng() % bits;
+			if (bit < len * 8) {
+				buf[bit / 8] ^= static_cast<uint8>(1 << (bit % 8));
+				res.Add(hash, sstd::hash_bytes(buf.data(), len, seed));
+				buf[bit / 8] ^= static_cast<uint8>(1 << (bit % 8));
+			}
+			else {
+				res.Add(hash, sstd::hash_bytes(buf.data(), len, seed ^ (1ull << (bit - len * 8))));
+			}
+		}
+	}
+	char name[64];
+	std::snprintf(name, sizeof(name), "bytes, length %zu", len);
+	res.Check(name, 0.02);
+}
+
+// All the hashes of a key set have to be different
+static void _Check_Unique(const char* name, std::vector<uint64> hashes) {
+	const sizet count = hashes.size();
+	std::sort(hashes.begin(), hashes.end());
+	const sizet unique = static_cast<sizet>(std::unique(hashes.begin(), hashes.end()) - hashes.begin());
+	std::printf("  %-28s %zu keys, %zu collisions\n", name, count, count - unique);
+	SSTD_CHECK(unique == count);
+}
+
+// The tables take the slot from the low bits and the control byte from the top 7 ( see hash_table.hpp ),
+// so both have to spread evenly even for keys that only differ in a few bits
+// Checked with a chi squared over the buckets, which should be about the amount of buckets
+static void _Check_Spread(const char* name, const std::vector<uint64>& hashes) {
+	const int low_bits = 12;
+	std::vector<double> low(1 << low_bits, 0);
+	std::vector<double> top(128, 0);
+	for (const uint64& hash : hashes) {
+		low[hash & ((1 << low_bits) - 1)] += 1;
+		top[hash >> 57] += 1;
+	}
+	auto chi = [&](const std::vector<double>& buckets) {
+		const double expected = static_cast<double>(hashes.size()) / buckets.size();
+		double res = 0;
+		for (const double& n : buckets) {
+			res += (n - expected) * (n - expected) / expected;
+		}
+		// Normalized, 1 on average, a few standard deviations ( sqrt(2 / buckets) ) either way is fine
+		return res / buckets.size();
+	};
+	const double chi_low = chi(low);
+	const double chi_top = chi(top);
+	std::printf("  %-28s low bits %.3f, top bits %.3f\n", name, chi_low, chi_top);
+	SSTD_CHECK(chi_low < 1.15 && chi_top < 1.6);
+}
+
+static void _Check_Keys(const char* name, const std::vector<uint64>& hashes) {
+	_Check_Unique(name, hashes);
+	_Check_Spread(name, hashes);
+}
+
+int main() {
+	std::mt19937_64 rng(42);
+
+	std::printf("avalanche\n");
+	const sizet lengths[] = { 0, 1, 2, 3, 4, 7, 8, 9, 15, 16, 17, 31, 32, 33, 47, 48, 49, 64, 100, 255,
+		sstd::_Long_Hash_Bytes - 1, sstd::_Long_Hash_Bytes, sstd::_Long_Hash_Bytes + 1, 1000, 1024, 1087, 4133 };
+	for (const sizet& len : lengths) {
+		_Bytes_Avalanche(rng, len);
+	}
+	{
+		_Avalanche res;
+		for (int sample = 0; sample < 5000; ++sample) {
+			const uint64 x = rng();
+			const uint64 seed = rng();
+			const uint64 hash = sstd::hash<uint64>()(x, seed);
+			for (int bit = 0; bit < 64; ++bit) {
+				res.Add(hash, sstd::hash<uint64>()(x ^ (1ull << bit), seed));
+				res.Add(hash, sstd::hash<uint64>()(x, seed ^ (1ull << bit)));
+			}
+		}
+		res.Check("integers", 0.02);
+	}
+
+	std::printf("collisions and spread\n");
+	const sizet count = 1 << 20;
+	const uint64 seed = rng();
+	std::vector<uint64> hashes(count);
+
+	for (sizet i = 0; i < count; ++i) {
+		hashes[i] = sstd::hash<uint64>()(i, seed);
+	}
+	_Check_Keys("sequential integers", hashes);
+	for (sizet i = 0; i < count; ++i) {
+		hashes[i] = sstd::hash<uint64>()(i, 0);
+	}
+	_Check_Keys("sequential integers, seed 0", hashes);
+	for (sizet i = 0; i < count; ++i) {
+		hashes[i] = sstd::hash<uint64>()(static_cast<uint64>(i) << 32, seed);
+	}
+	_Check_Keys("integers << 32", hashes);
+	for (sizet i = 0; i < count; ++i) {
+		hashes[i] = sstd::hash<uint64>()(static_cast<uint64>(i) * 4096, seed);
+	}
+	_Check_Keys("integers * 4096", hashes);
+	for (sizet i = 0; i < count; ++i) {
+		hashes[i] = sstd::hash<double>()(static_cast<double>(i), seed);
+	}
+	_Check_Keys("sequential doubles", hashes);
+
+	for (sizet i = 0; i < count; ++i) {
+		hashes[i] = sstd::hash<std::string>()("key_" + std::to_string(i), seed);
+	}
+	_Check_Keys("\"key_<n>\"", hashes);
+	for (sizet i = 0; i < count; ++i) {
+		hashes[i] = sstd::hash<std::string>()("https://example.com/users/" + std::to_string(i) + "/profile", seed);
+	}
+	_Check_Keys("urls", hashes);
+
+	// Long strings that only differ in one byte, on the accumulator path ( and its partial last stripe )
+	{
+		std::string base(1500, 'a');
+		std::vector<uint64> long_hashes;
+		for (sizet pos = 0; pos < base.size(); ++pos) {
+			for (int c = 0; c < 256; c += 3) {
+				if (c == 'a') {
+					continue;
+				}
+				base[pos] = static_cast<char>(c);
+				long_hashes.push_back(sstd::hash<std::string>()(base, seed));
+			}
+			base[pos] = 'a';
+		}
+		long_hashes.push_back(sstd::hash<std::string>()(base, seed));
+		_Check_Keys("1500 bytes, one byte changed", long_hashes);
+	}
+
+	// The same stripes in a different order
+	{
+		std::vector<uint8> buf(2048);
+		for (uint8& b : buf) {
+			b = static_cast<uint8>(rng());
+		}
+		const sizet stripes = buf.size() / 64;
+		std::vector<uint64> swap_hashes;
+		swap_hashes.push_back(sstd::hash_bytes(buf.data(), buf.size(), seed));
+		for (sizet a = 0; a < stripes; ++a) {
+			for (sizet b = a + 1; b < stripes; ++b) {
+				std::swap_ranges(buf.begin() + a * 64, buf.begin() + a * 64 + 64, buf.begin() + b * 64);
+				swap_hashes.push_back(sstd::hash_bytes(buf.data(), buf.size(), seed));
+				std::swap_ranges(buf.begin() + a * 64, buf.begin() + a * 64 + 64, buf.begin() + b * 64);
+			}
+		}
+		_Check_Unique("2048 bytes, stripes swapped", swap_hashes);
+	}
+
+	// Zero bytes of every length, only the length tells them apart
+	{
+		const std::vector<uint8> zeros(5000, 0);
+		std::vector<uint64> length_hashes;
+		for (sizet len = 0; len < zeros.size(); ++len) {
+			length_hashes.push_back(sstd::hash_bytes(zeros.data(), len, seed));
+		}
+		_Check_Unique("zeros of every length", length_hashes);
+	}
+
+	// The same key under different seeds
+	{
+		std::vector<uint64> seed_hashes;
+		for (sizet i = 0; i < 100000; ++i) {
+			seed_hashes.push_back(sstd::hash<std::string>()("the same key", i));
+		}
+		_Check_Unique("one key, 100000 seeds", seed_hashes);
+	}
+
+	// Equal keys hash the same no matter which type they come as
+	SSTD_CHECK(sstd::hash<std::string>()("abc", seed) == sstd::hash<std::string_view>()(std::string_view("abc"), seed));
+	SSTD_CHECK(sstd::hash<double>()(0.0, seed) == sstd::hash<double>()(-0.0, seed));
+
+	std::printf("hash: ok\n");
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include "check.hpp"
+#include "huge_page.hpp"
+#include "vector.hpp"
+
+#include <cstring>
+#include <string>
+
+using sstd::sizet;
+using sstd::uint64;
+
+// Where huge_page_allocator switches from malloc to its own mappings
+static const sizet _Huge_Bytes = 2 * 1024 * 1024;
+
+// A huge_page_allocator that counts how a vector grows
+struct _Counting_Huge_Page_Allocator : sstd::huge_page_allocator {
+	sizet* allocates;
+	// Reallocations from one mapping to another, those go through _Remap
+	sizet* remaps;
+
+	_Counting_Huge_Page_Allocator(sizet& _allocates, sizet& _remaps) :
+		sstd::huge_page_allocator(sstd::huge_pages::transparent), allocates(&_allocates), remaps(&_remaps) {
+
+	}
+
+	void* allocate(const sizet& bytes) {
+		++*allocates;
+		return sstd::huge_page_allocator::allocate(bytes);
+	}
+	void* reallocate(void* ptr, const sizet& old_bytes, const sizet& new_bytes) {
+		if (old_bytes >= _Huge_Bytes && new_bytes >= _Huge_Bytes) {
+			++*remaps;
+		}
+		return sstd::huge_page_allocator::reallocate(ptr, old_bytes, new_bytes);
+	}
+};
+
+static void _Fill(void* ptr, const sizet& bytes, const uint64& salt) {
+	uint64* words = static_cast<uint64*>(ptr);
+	for (sizet i = 0; i < bytes / sizeof(uint64); ++i) {
+		words[i] = i * 0x9E3779B97F4A7C15ull ^ salt;
+	}
+}
+
+static bool _Intact(const void* ptr, const sizet& bytes, const uint64& salt) {
+	const uint64* words = static_cast<const uint64*>(ptr);
+	for (sizet i = 0; i < bytes / sizeof(uint64); ++i) {
+		if (words[i] != (i * 0x9E3779B97F4A7C15ull ^ salt)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Grow and shrink one block across the malloc / mapping boundary and between mappings, the bytes have to survive every step
+static void _Check_Reallocate(sstd::huge_page_allocator alloc) {
+	const sizet steps[] = { 3 * _Huge_Bytes, 17 * _Huge_Bytes / 2, 5 * _Huge_Bytes, _Huge_Bytes - 64, 4096, 2 * _Huge_Bytes, _Huge_Bytes };
+	sizet bytes = 1024;
+	void* ptr = alloc.allocate(bytes);
+	_Fill(ptr, bytes, 1);
+	for (const sizet& next : steps) {
+		ptr = alloc.reallocate(ptr, bytes, next);
+		SSTD_CHECK(ptr != nullptr);
+		SSTD_CHECK(_Intact(ptr, bytes < next ? bytes : next, 1));
+		// The new part has to be writable too
+		bytes = next;
+		_Fill(ptr, bytes, 1);
+	}
+	alloc.deallocate(ptr, bytes);
+	// ( Freeing nothing is fine )
+	alloc.deallocate(nullptr, bytes);
+}
+
+int main() {
+	// A vector of trivially relocatable elements, from the inline / malloc sizes through 2 MiB and a few remaps
+	{
+		sizet allocates = 0;
+		sizet remaps = 0;
+		sstd::vector<uint64, 0, _Counting_Huge_Page_Allocator> v{ _Counting_Huge_Page_Allocator(allocates, remaps) };
+		const sizet count = 8 * 1024 * 1024;
+		sizet capacity = v.capacity();
+		for (sizet i = 0; i < count; ++i) {
+			v.push_back(i * 3);
+			if (v.capacity() != capacity) {
+				// Check right after every growth, while the moved block is fresh
+				capacity = v.capacity();
+				SSTD_CHECK(v[0] == 0 && v[i / 2] == i / 2 * 3 && v[i] == i * 3);
+			}
+		}
+		SSTD_CHECK(v.size() == count);
+		for (sizet i = 0; i < count; ++i) {
+			SSTD_CHECK(v[i] == i * 3);
+		}
+		// Only the first block gets allocated, every growth after that goes through reallocate
+		SSTD_CHECK(allocates == 1);
+		// 2 MiB, 4, 8, 16, 32 to 64 MiB
+		SSTD_CHECK(remaps >= 5);
+	}
+
+	// Elements that have to be relocated one by one, across the same boundary
+	{
+		sstd::vector<std::string, 0, sstd::huge_page_allocator> v{ sstd::huge_page_allocator(sstd::huge_pages::transparent) };
+		const sizet count = 2 * _Huge_Bytes / sizeof(std::string) + 1000;
+		for (sizet i = 0; i < count; ++i) {
+			v.push_back(std::to_string(i) + std::string(20, 'x'));
+		}
+		for (sizet i = 0; i < count; i += 97) {
+			SSTD_CHECK(v[i] == std::to_string(i) + std::string(20, 'x'));
+		}
+	}
+
+	// Every page mode, the reserved one falls back when there are no reserved huge pages
+	_Check_Reallocate(sstd::huge_page_allocator(sstd::huge_pages::none));
+	_Check_Reallocate(sstd::huge_page_allocator(sstd::huge_pages::transparent));
+	_Check_Reallocate(sstd::huge_page_allocator(sstd::huge_pages::reserved));
+
+	// Bound to NUMA node 0 ( which always exists ), and nodes the binding ignores
+	_Check_Reallocate(sstd::huge_page_allocator(sstd::huge_pages::transparent, 0));
+	_Check_Reallocate(sstd::huge_page_allocator(sstd::huge_pages::transparent, 1000));
+	{
+		const sstd::huge_page_allocator alloc(sstd::huge_pages::reserved, 0);
+		SSTD_CHECK(alloc.pages() == sstd::huge_pages::reserved);
+		SSTD_CHECK(alloc.node() == 0);
+	}
+
+	std::printf("huge_page ok\n");
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include "check.hpp"
+#include "pool.hpp"
+#include "unordered_map.hpp"
+
+#include <string>
+
+// A pool_allocator that counts the requests the pool serves
+struct _Counting_Pool_Allocator : sstd::pool_allocator {
+	sstd::sizet* pool_hits;
+
+	_Counting_Pool_Allocator(sstd::pool& _pool, sstd::sizet& hits) :
+		sstd::pool_allocator(_pool), pool_hits(&hits) {
+
+	}
+
+	void* allocate(const sstd::sizet& bytes) {
+		if (bytes <= node_size()) {
+			++*pool_hits;
+		}
+		return sstd::pool_allocator::allocate(bytes);
+	}
+};
+
+int main() {
+	// Plain nodes, freed ones get reused first
+	{
+		sstd::pool p(24);
+		SSTD_CHECK(p.node_size() >= 24);
+		void* a = p.allocate();
+		void* b = p.allocate();
+		SSTD_CHECK(a != b);
+		p.deallocate(a);
+		SSTD_CHECK(p.allocate() == a);
+	}
+
+	// A node map gets every node from the pool
+	{
+		const int count = 10000;
+		sstd::sizet hits = 0;
+		sstd::pool p(64);
+		{
+			sstd::node_unordered_map<int, int, sstd::hash<int>, sstd::_Double_Hash_Prob<int, sstd::hash<int> >, _Counting_Pool_Allocator> m{ _Counting_Pool_Allocator(p, hits) };
+			for (int i = 0; i < count; ++i) {
+				m[i] = i * 2;
+			}
+			for (int i = 0; i < count; ++i) {
+				SSTD_CHECK(m[i] == i * 2);
+			}
+			SSTD_CHECK(hits >= static_cast<sstd::sizet>(count));
+		}
+	}
+
+	// Elements that need their destructor
+	{
+		sstd::pool p(128);
+		sstd::node_unordered_map<int, std::string, sstd::hash<int>, sstd::_Double_Hash_Prob<int, sstd::hash<int> >, sstd::pool_allocator> m{ sstd::pool_allocator(p) };
+		for (int i = 0; i < 5000; ++i) {
+			m[i] = std::string(40, 'x');
+		}
+		for (int i = 0; i < 5000; i += 2) {
+			m.erase(i);
+		}
+		SSTD_CHECK(m.size() == 2500);
+		m.clear();
+	}
+
+	std::printf("pool ok\n");
+	return 0;
+}
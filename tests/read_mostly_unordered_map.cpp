@@ -0,0 +1,211 @@
+// One writer changing a read_mostly_unordered_map under readers that never lock, meant to run under thread sanitizer:
+//
+//   g++ -std=c++17 -O1 -g -fsanitize=thread -pthread -I.. read_mostly_unordered_map.cpp -o read_mostly_test && ./read_mostly_test
+//
+// Thread sanitizer doesn't model the fences _Epoch_Domain relies on ( GCC warns about it ), so run it with
+// -fsanitize=address,undefined -pthread as well, that one catches an element or a table freed under a reader
+//
+// The writer inserts, overwrites, erases and forces resizes ( growing, reserve, and the rebuilds that drop the deleted slots ),
+// while the readers check that whatever they find belongs to its key, and that the keys the writer never erases are always there
+// Then a reader parks inside of visit while the writer replaces and erases its element and retires a few tables:
+// the element has to stay alive until the reader leaves, and get freed by the next retirement after that
+
+#include "check.hpp"
+#include "read_mostly_unordered_map.hpp"
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using key_type = sstd::uint64;
+
+static const unsigned _Readers = 4;
+static const key_type _Keys = 8192;
+// The keys below this are inserted before the readers start, and never erased ( only overwritten )
+static const key_type _Stable = 256;
+static const unsigned _Writes = 100000;
+
+// The element of a key always encodes the key, so a reader can tell a torn or misplaced element apart
+static key_type _Value(const key_type& key, const key_type& version) {
+	return key << 20 | version;
+}
+
+struct _Rng {
+	sstd::uint64 state;
+
+	sstd::uint64 operator()() noexcept {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+};
+
+using map_type = sstd::read_mostly_unordered_map<key_type, key_type>;
+
+static void _Reader(const map_type& map, const unsigned id, const std::atomic<bool>& done, std::atomic<sstd::uint64>& hits) {
+	_Rng rng{ 0x9E3779B97F4A7C15ull * (id + 1) };
+	sstd::uint64 found = 0;
+	while (!done.load(std::memory_order_acquire)) {
+		const key_type key = rng() % _Keys;
+		key_type out;
+		if (map.find(key, out)) {
+			SSTD_CHECK(out >> 20 == key);
+			++found;
+		}
+		else {
+			SSTD_CHECK(key >= _Stable);
+		}
+		const bool visited = map.visit(key, [&](const key_type& elt) {
+			SSTD_CHECK(elt >> 20 == key);
+		});
+		SSTD_CHECK(visited || key >= _Stable);
+		SSTD_CHECK(key >= _Stable || map.contains(key));
+	}
+	hits.fetch_add(found, std::memory_order_relaxed);
+}
+
+// An element that counts how many of its kind are alive, and can flag its own destruction
+static std::atomic<long> _Live{ 0 };
+struct _Tracked {
+	key_type key;
+	std::atomic<bool>* destroyed;
+
+	_Tracked(const key_type& _key, std::atomic<bool>* _destroyed = nullptr) :
+		key(_key), destroyed(_destroyed) {
+		++_Live;
+	}
+	_Tracked(const _Tracked& other) :
+		key(other.key), destroyed(other.destroyed) {
+		++_Live;
+	}
+	~_Tracked() {
+		--_Live;
+		if (destroyed) {
+			destroyed->store(true);
+		}
+	}
+};
+
+int main() {
+	// Readers against a writer
+	{
+		map_type map;
+		std::unordered_map<key_type, key_type> expected;
+		for (key_type key = 0; key < _Stable; ++key) {
+			map.insert(key, _Value(key, 0));
+			expected[key] = _Value(key, 0);
+		}
+
+		std::atomic<bool> done(false);
+		std::atomic<sstd::uint64> hits(0);
+		std::vector<std::thread> pool;
+		for (unsigned t = 0; t < _Readers; ++t) {
+			pool.emplace_back(_Reader, std::cref(map), t, std::cref(done), std::ref(hits));
+		}
+
+		_Rng rng{ 42 };
+		sstd::sizet capacity = map.capacity();
+		sstd::sizet resizes = 0;
+		for (unsigned i = 1; i <= _Writes; ++i) {
+			const sstd::uint64 r = rng();
+			const key_type key = (r >> 8) % _Keys;
+			switch (r % 16) {
+			case 0: case 1: case 2: case 3: case 4: {
+				const key_type value = _Value(key, i);
+				SSTD_CHECK(map.insert_or_assign(key, value) == (expected.count(key) == 0));
+				expected[key] = value;
+				break;
+			}
+			case 5: case 6:
+				SSTD_CHECK(map.try_emplace(key, _Value(key, i)) == expected.emplace(key, _Value(key, i)).second);
+				break;
+			case 7:
+				// Grow well past what's needed, now and then
+				if (i % 1024 == 7) {
+					map.reserve(map.size() * 2);
+					break;
+				}
+				[[fallthrough]];
+			default:
+				// The erases leave deleted slots behind, so the table keeps getting rebuilt even once it stopped growing
+				if (key >= _Stable) {
+					SSTD_CHECK(map.erase(key) == expected.erase(key));
+				}
+				break;
+			}
+			if (map.capacity() != capacity) {
+				capacity = map.capacity();
+				++resizes;
+			}
+		}
+		done.store(true, std::memory_order_release);
+		for (std::thread& thread : pool) {
+			thread.join();
+		}
+		SSTD_CHECK(resizes >= 3);
+		SSTD_CHECK(hits.load() > 0);
+
+		SSTD_CHECK(map.size() == expected.size());
+		for (key_type key = 0; key < _Keys; ++key) {
+			key_type out = 0;
+			const bool found = map.find(key, out);
+			SSTD_CHECK(found == (expected.count(key) != 0));
+			SSTD_CHECK(!found || out == expected[key]);
+		}
+	}
+
+	// A reader parked inside of visit holds back everything retired after it started
+	{
+		std::atomic<bool> destroyed(false);
+		std::atomic<int> stage(0);
+		{
+			sstd::read_mostly_unordered_map<key_type, _Tracked> map;
+			map.try_emplace(key_type(7), key_type(7), &destroyed);
+
+			std::thread reader([&]() {
+				const bool found = map.visit(7, [&](const _Tracked& elt) {
+					stage.store(1);
+					while (stage.load() != 2) {
+						std::this_thread::yield();
+					}
+					// Whatever the writer did in the meantime, this is still the element that was found
+					SSTD_CHECK(elt.key == 7 && elt.destroyed == &destroyed);
+					SSTD_CHECK(!destroyed.load());
+				});
+				SSTD_CHECK(found);
+			});
+			while (stage.load() != 1) {
+				std::this_thread::yield();
+			}
+
+			// Replace the element a few times, erase it, and go through a few tables
+			for (int i = 0; i < 100; ++i) {
+				map.insert(key_type(7), _Tracked(7));
+			}
+			map.erase(7);
+			const sstd::sizet capacity = map.capacity();
+			for (key_type key = 100; key < 5000; ++key) {
+				map.insert(key, _Tracked(key));
+			}
+			map.reserve(20000);
+			SSTD_CHECK(map.capacity() > capacity);
+			SSTD_CHECK(!destroyed.load());
+			// Nothing retired since the reader parked got freed
+			SSTD_CHECK(_Live.load() > static_cast<long>(map.size()) + 100);
+
+			stage.store(2);
+			reader.join();
+			// The reader is gone, so the next retirement frees everything
+			map.insert(key_type(100), _Tracked(100));
+			SSTD_CHECK(destroyed.load());
+			SSTD_CHECK(_Live.load() == static_cast<long>(map.size()));
+		}
+		// And the map frees the rest
+		SSTD_CHECK(_Live.load() == 0);
+	}
+
+	std::printf("read_mostly_unordered_map: ok\n");
+	return 0;
+}
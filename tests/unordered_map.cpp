@@ -0,0 +1,404 @@
+// With the counters, so the reseeds can be checked ( see hash_table_stats )
+#define SSTD_HASH_TABLE_STATS
+
+#include "check.hpp"
+#include "mapped_unordered_map.hpp"
+#include "unordered_map.hpp"
+#include "unordered_set.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using sstd::sizet;
+
+// A copy would share the table, so there is none
+static_assert(!std::is_copy_constructible<sstd::unordered_map<int, int> >::value, "tables can't be copied");
+static_assert(!std::is_copy_assignable<sstd::unordered_set<int> >::value, "tables can't be copied");
+static_assert(!std::is_copy_constructible<sstd::node_unordered_map<int, int> >::value, "tables can't be copied");
+static_assert(std::is_nothrow_move_constructible<sstd::unordered_map<int, std::string> >::value, "moving a table only moves pointers");
+
+// The iterators hand out pairs of references, it-> goes through a proxy
+using _Map_Iterator = sstd::unordered_map<int, std::string>::iterator;
+using _Map_Const_Iterator = sstd::unordered_map<int, std::string>::const_iterator;
+static_assert(std::is_same<std::iterator_traits<_Map_Iterator>::value_type, std::pair<const int, std::string> >::value, "value_type");
+static_assert(std::is_same<std::iterator_traits<_Map_Const_Iterator>::value_type, std::pair<const int, std::string> >::value, "value_type");
+static_assert(std::is_same<std::iterator_traits<_Map_Iterator>::reference, std::pair<const int&, std::string&> >::value, "reference");
+
+static std::string _Value(const int& i) {
+	// Longer than the small string buffer, so a double free shows up
+	return std::to_string(i) + std::string(24, 'v');
+}
+
+template<typename _Map>
+static void _Fill(_Map& map, const int& first, const int& last) {
+	for (int i = first; i < last; ++i) {
+		map.insert(i, _Value(i));
+	}
+}
+
+template<typename _Map>
+static void _Check_Holds(const _Map& map, const int& first, const int& last) {
+	SSTD_CHECK(map.size() == static_cast<sizet>(last - first));
+	for (int i = first; i < last; ++i) {
+		SSTD_CHECK(map.at(i) == _Value(i));
+	}
+}
+
+// Move construction and assignment take the whole table over, and leave an empty table that still works
+template<typename _Map>
+static void _Test_Move(const bool& incremental) {
+	_Map a;
+	a.incremental_rehash(incremental);
+	_Fill(a, 0, 1000);
+	// Keep going until a rehash just started, so the old table gets moved along too
+	int last = 1000;
+	while (incremental && !a.rehashing()) {
+		a.insert(last, _Value(last));
+		++last;
+	}
+
+	_Map b(std::move(a));
+	_Check_Holds(b, 0, last);
+	SSTD_CHECK(b.incremental_rehash() == incremental);
+	SSTD_CHECK(b.rehashing() == incremental);
+	SSTD_CHECK(!a.rehashing());
+	SSTD_CHECK(a.size() == 0 && a.empty());
+	SSTD_CHECK(a.find(5) == a.end());
+	SSTD_CHECK(a.begin() == a.end());
+	// The moved from table can be filled again
+	_Fill(a, 2000, 2100);
+	_Check_Holds(a, 2000, 2100);
+
+	// Over a table that holds elements of its own
+	_Map c;
+	_Fill(c, 5000, 5300);
+	c = std::move(b);
+	_Check_Holds(c, 0, last);
+	SSTD_CHECK(b.size() == 0);
+	c.finish_rehash();
+	_Check_Holds(c, 0, last);
+	for (int i = 0; i < last; ++i) {
+		SSTD_CHECK(c.erase(i) == 1);
+	}
+	_Fill(c, 0, 500);
+	SSTD_CHECK(c.size() == 500);
+
+	// Onto itself does nothing
+	_Map& self = c;
+	c = std::move(self);
+	SSTD_CHECK(c.size() == 500);
+}
+
+// -----------------------------------------
+//
+//   Incremental rehash
+//
+// -----------------------------------------
+
+// ( _Quadratic_Prob1 isn't in here, not all of its constants visit every slot )
+template<typename T, typename _Hash>
+using _Quadratic_Prob = sstd::_Quadratic_Prob2<T, 0, 0, _Hash>;
+
+// Keys from _Clump on all hash the same, no matter the seed
+static const int _Clump = 1 << 24;
+struct _Clumped_Hash {
+	sizet operator()(const int& key) const noexcept {
+		return key >= _Clump ? 0 : static_cast<sizet>(key);
+	}
+};
+
+using _Ref_Map = std::unordered_map<int, std::string>;
+
+// Iterating ( in the middle of a rehash too ) visits every element exactly once
+template<typename _Map>
+static void _Check_Same(const _Map& map, const _Ref_Map& ref) {
+	SSTD_CHECK(map.size() == ref.size());
+	std::unordered_set<int> seen;
+	for (typename _Map::const_iterator it = map.begin(); it != map.end(); ++it) {
+		const _Ref_Map::const_iterator found = ref.find(it->first);
+		SSTD_CHECK(found != ref.end() && found->second == it->second);
+		SSTD_CHECK(seen.insert(it->first).second);
+	}
+	SSTD_CHECK(seen.size() == ref.size());
+}
+
+// A key that still lives in the old table, the one that gets migrated last
+// Iteration goes through the old table first, and stats().migrating is how many elements are left in there
+template<typename _Map>
+static bool _Old_Key(const _Map& map, int& key) {
+	const sizet migrating = map.rehashing() ? map.stats().migrating : 0;
+	if (migrating == 0) {
+		return false;
+	}
+	typename _Map::const_iterator it = map.begin();
+	for (sizet i = 1; i < migrating; ++i) {
+		++it;
+	}
+	key = it.key();
+	return true;
+}
+
+// The same random operations on a map with incremental_rehash(true) and on a std::unordered_map
+// The keys come from a range that keeps growing, so the table goes through a lot of rehashes, then everything gets erased
+template<typename _Map>
+static void _Test_Incremental(const unsigned& seed) {
+	std::mt19937 rng(seed);
+	_Map map;
+	map.incremental_rehash(true);
+	_Ref_Map ref;
+	// How often the interesting cases came up
+	sizet old_keys = 0;
+	sizet iterations = 0;
+	sizet reserves = 0;
+	sizet finishes = 0;
+
+	// Overwrite or erase a key that hasn't been migrated yet
+	auto touch_old_key = [&](const int& op) {
+		int old;
+		if (!_Old_Key(map, old)) {
+			return;
+		}
+		++old_keys;
+		if (rng() % 2) {
+			map[old] = _Value(-op);
+			ref[old] = _Value(-op);
+			SSTD_CHECK(map.at(old) == _Value(-op));
+		}
+		else {
+			SSTD_CHECK(map.erase(old) == 1 && ref.erase(old) == 1);
+			SSTD_CHECK(!map.contains(old));
+		}
+	};
+
+	// Every rehash gets cut short a few operations in, by turns with finish_rehash, reserve, or not at all
+	sizet migrations = 0;
+	int cut_at = -1;
+	for (int op = 0; op < 40000; ++op) {
+		const bool rehashing = map.rehashing();
+		const int key = static_cast<int>(rng() % (64 + op / 3));
+		const unsigned what = rng() % 100;
+		if (what < 40) {
+			const std::string value = _Value(op);
+			const bool inserted = map.insert_or_assign(key, value).second;
+			SSTD_CHECK(inserted == (ref.count(key) == 0));
+			ref[key] = value;
+		}
+		else if (what < 50) {
+			const std::pair<typename _Map::iterator, bool> res = map.emplace(key, _Value(key));
+			const std::pair<_Ref_Map::iterator, bool> ref_res = ref.emplace(key, _Value(key));
+			SSTD_CHECK(res.second == ref_res.second);
+			SSTD_CHECK(res.first->second == ref_res.first->second);
+		}
+		else if (what < 58) {
+			map[key] += "+";
+			ref[key] += "+";
+		}
+		else if (what < 78) {
+			SSTD_CHECK(map.erase(key) == ref.erase(key));
+		}
+		else if (what < 95) {
+			const _Ref_Map::const_iterator found = ref.find(key);
+			SSTD_CHECK(map.contains(key) == (found != ref.end()));
+			SSTD_CHECK(found == ref.end() || map.at(key) == found->second);
+		}
+		else {
+			touch_old_key(op);
+		}
+
+		if (!rehashing && map.rehashing()) {
+			++migrations;
+			cut_at = op + 1 + static_cast<int>(rng() % 16);
+		}
+		if (op == cut_at && map.rehashing()) {
+			touch_old_key(op);
+			++iterations;
+			_Check_Same(map, ref);
+			if (migrations % 3 == 1) {
+				++finishes;
+				map.finish_rehash();
+				SSTD_CHECK(!map.rehashing());
+			}
+			else if (migrations % 3 == 2 && reserves < 3) {
+				// Finishes the rehash first
+				++reserves;
+				map.reserve(map.size());
+				SSTD_CHECK(!map.rehashing());
+			}
+			_Check_Same(map, ref);
+		}
+	}
+	_Check_Same(map, ref);
+	SSTD_CHECK(old_keys > 0 && iterations > 0 && reserves > 0 && finishes > 0);
+
+	// Erase down to empty, in a random order, through the last rehash
+	std::vector<int> keys;
+	for (const std::pair<const int, std::string>& kv : ref) {
+		keys.push_back(kv.first);
+	}
+	std::shuffle(keys.begin(), keys.end(), rng);
+	for (sizet i = 0; i < keys.size(); ++i) {
+		SSTD_CHECK(map.erase(keys[i]) == 1);
+		ref.erase(keys[i]);
+		if (i % 1024 == 0) {
+			_Check_Same(map, ref);
+		}
+	}
+	SSTD_CHECK(map.empty() && map.begin() == map.end());
+	map.finish_rehash();
+	SSTD_CHECK(!map.rehashing() && map.begin() == map.end());
+}
+
+// A probing sequence that gets too long in the middle of a rehash makes the watchdog reseed,
+// which finishes the rehash first and then hashes everything again
+template<typename _ProbT>
+static void _Test_Reseed_While_Migrating() {
+	using map_type = sstd::unordered_map<int, std::string, _Clumped_Hash, _ProbT>;
+	map_type map;
+	map.incremental_rehash(true);
+	_Ref_Map ref;
+	// Big enough that the migration is still going on when the clumped keys get too far
+	int key = 0;
+	while (!map.rehashing() || map.size() < 30000) {
+		map.insert(key, _Value(key));
+		ref[key] = _Value(key);
+		++key;
+	}
+	const sizet reseeds = map.stats().reseeds;
+	for (int clumped = _Clump; map.rehashing(); ++clumped) {
+		map.insert(clumped, _Value(clumped));
+		ref[clumped] = _Value(clumped);
+	}
+	SSTD_CHECK(map.stats().reseeds == reseeds + 1);
+	_Check_Same(map, ref);
+	for (int i = 0; i < key; i += 2) {
+		SSTD_CHECK(map.erase(i) == 1);
+		ref.erase(i);
+	}
+	_Check_Same(map, ref);
+}
+
+// save() refuses to write a table that is half in the old table, and works again once the rehash is done
+template<typename _ProbT, typename _Storage>
+static void _Test_Save_While_Migrating(const char* path) {
+	using map_type = sstd::unordered_map<int, int, sstd::hash<int>, _ProbT, _Storage>;
+	map_type map;
+	map.incremental_rehash(true);
+	int key = 0;
+	while (!map.rehashing() || map.size() < 1000) {
+		map.insert(key, key * 3);
+		++key;
+	}
+	bool thrown = false;
+	try {
+		map.save(path);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	SSTD_CHECK(thrown);
+	SSTD_CHECK(map.rehashing() && map.size() == static_cast<sizet>(key));
+
+	map.finish_rehash();
+	map.save(path);
+	{
+		const sstd::mapped_unordered_map<int, int, sstd::hash<int>, _ProbT, _Storage> mapped = map_type::open_mapped(path);
+		SSTD_CHECK(mapped.size() == map.size());
+		for (int i = 0; i < key; ++i) {
+			SSTD_CHECK(mapped.at(i) == i * 3);
+		}
+	}
+	std::remove(path);
+}
+
+// Every storage with one probing policy
+template<template<typename, typename> class _ProbT>
+static void _Test_Incremental_Probing(const unsigned& seed) {
+	using prob_type = _ProbT<int, sstd::hash<int> >;
+	_Test_Incremental<sstd::unordered_map<int, std::string, sstd::hash<int>, prob_type, sstd::_Inline_Storage<int, std::string> > >(seed);
+	_Test_Incremental<sstd::unordered_map<int, std::string, sstd::hash<int>, prob_type, sstd::_Split_Storage<int, std::string> > >(seed + 1);
+	_Test_Incremental<sstd::unordered_map<int, std::string, sstd::hash<int>, prob_type, sstd::_Node_Storage<int, std::string> > >(seed + 2);
+	_Test_Reseed_While_Migrating<_ProbT<int, _Clumped_Hash> >();
+	_Test_Save_While_Migrating<prob_type, sstd::_Inline_Storage<int, int> >("unordered_map_test.snapshot");
+	_Test_Save_While_Migrating<prob_type, sstd::_Split_Storage<int, int> >("unordered_map_test.snapshot");
+}
+
+int main() {
+	using map_type = sstd::unordered_map<int, std::string>;
+	using node_map_type = sstd::node_unordered_map<int, std::string>;
+	using group_map_type = sstd::unordered_map<int, std::string, sstd::hash<int>, sstd::_Group_Prob<int, sstd::hash<int> > >;
+	using robin_map_type = sstd::unordered_map<int, std::string, sstd::hash<int>, sstd::_Robin_Hood_Prob<int, sstd::hash<int> > >;
+
+	// Moving a table
+	for (const bool incremental : { false, true }) {
+		_Test_Move<map_type>(incremental);
+		_Test_Move<node_map_type>(incremental);
+		_Test_Move<group_map_type>(incremental);
+		_Test_Move<robin_map_type>(incremental);
+	}
+
+	// The nodes of a node map stay where they are, references survive the move
+	{
+		node_map_type a;
+		_Fill(a, 0, 100);
+		const std::string* before = &a.at(42);
+		node_map_type b(std::move(a));
+		SSTD_CHECK(&b.at(42) == before);
+		// Destroying the moved from map doesn't take the nodes with it
+		{
+			node_map_type gone(std::move(a));
+		}
+		_Check_Holds(b, 0, 100);
+	}
+
+	// it->first and it->second, through the iterator and the const iterator
+	{
+		map_type map;
+		_Fill(map, 0, 200);
+		int sum = 0;
+		for (map_type::iterator it = map.begin(); it != map.end(); ++it) {
+			SSTD_CHECK(it->second == _Value(it->first));
+			sum += it->first;
+			it->second += "!";
+		}
+		SSTD_CHECK(sum == 199 * 200 / 2);
+		const map_type& view = map;
+		for (map_type::const_iterator it = view.begin(); it != view.end(); ++it) {
+			SSTD_CHECK(it->second == _Value(it->first) + "!");
+			SSTD_CHECK(&it->first == &it.key() && &it->second == &it.value());
+		}
+		SSTD_CHECK(map.find(7)->second == _Value(7) + "!");
+	}
+
+	// Incremental rehash
+	_Test_Incremental_Probing<sstd::_Linear_Prob>(1);
+	_Test_Incremental_Probing<_Quadratic_Prob>(11);
+	_Test_Incremental_Probing<sstd::_Double_Hash_Prob>(21);
+	_Test_Incremental_Probing<sstd::_Group_Prob>(31);
+	_Test_Incremental_Probing<sstd::_Robin_Hood_Prob>(41);
+
+	// Sets
+	{
+		sstd::unordered_set<std::string> a;
+		for (int i = 0; i < 500; ++i) {
+			a.insert(_Value(i));
+		}
+		sstd::unordered_set<std::string> b(std::move(a));
+		SSTD_CHECK(b.size() == 500 && b.contains(_Value(7)));
+		SSTD_CHECK(a.size() == 0 && !a.contains(_Value(7)));
+		a.insert(_Value(1));
+		b = std::move(a);
+		SSTD_CHECK(b.size() == 1 && b.contains(_Value(1)));
+	}
+
+	std::printf("unordered_map ok\n");
+	return 0;
+}
@@ -0,0 +1,177 @@
+#include "check.hpp"
+#include "vector.hpp"
+#include "unordered_map.hpp"
+#include "unordered_set.hpp"
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Long enough to be on the heap ( no small string optimization )
+static std::string _Str(const int& i) {
+	return std::string(32, 'a') + std::to_string(i);
+}
+
+template<sstd::sizet _Inline>
+static void _Test_Copy_Move(const int& count) {
+	using vec = sstd::vector<std::string, _Inline>;
+	vec a;
+	for (int i = 0; i < count; ++i) {
+		a.push_back(_Str(i));
+	}
+
+	// Copy
+	{
+		vec b = a;
+		SSTD_CHECK(b.size() == a.size());
+		SSTD_CHECK(count == 0 || b.data() != a.data());
+		for (int i = 0; i < count; ++i) {
+			SSTD_CHECK(b[i] == _Str(i));
+		}
+		b.push_back("x");
+		SSTD_CHECK(a.size() == static_cast<sstd::sizet>(count));
+	}
+	{
+		vec b;
+		b.push_back("old");
+		b = a;
+		SSTD_CHECK(b.size() == a.size());
+		for (int i = 0; i < count; ++i) {
+			SSTD_CHECK(b[i] == _Str(i));
+		}
+		b = b;
+		SSTD_CHECK(b.size() == a.size());
+	}
+
+	// Move
+	{
+		vec c = a;
+		const bool was_inline = c.is_inline();
+		vec d = std::move(c);
+		SSTD_CHECK(c.size() == 0);
+		SSTD_CHECK(d.size() == static_cast<sstd::sizet>(count));
+		SSTD_CHECK(d.is_inline() == was_inline);
+		for (int i = 0; i < count; ++i) {
+			SSTD_CHECK(d[i] == _Str(i));
+		}
+		// The moved from one is still usable
+		c.push_back("y");
+		SSTD_CHECK(c.size() == 1 && c[0] == "y");
+
+		vec e;
+		e.push_back("old");
+		e = std::move(d);
+		SSTD_CHECK(d.size() == 0);
+		SSTD_CHECK(e.size() == static_cast<sstd::sizet>(count));
+		for (int i = 0; i < count; ++i) {
+			SSTD_CHECK(e[i] == _Str(i));
+		}
+	}
+}
+
+// Moves never throw, so std::vector and co. move them instead of copying when they grow
+static_assert(std::is_nothrow_move_constructible<sstd::vector<std::string> >::value, "vector move is noexcept");
+static_assert(std::is_nothrow_move_assignable<sstd::vector<std::string> >::value, "vector move is noexcept");
+static_assert(std::is_nothrow_move_constructible<sstd::small_vector<std::string, 4> >::value, "small_vector move is noexcept");
+
+// Relocated by move constructing and destroying ( the string isn't trivially relocatable ), not by realloc
+struct _Named_Map {
+	std::string name;
+	sstd::unordered_map<int, std::string> map;
+};
+
+// Growing a vector of tables moves every table, the old ones must not take their memory with them
+template<typename _Vec>
+static void _Test_Tables(_Vec& v) {
+	const int count = 40;
+	for (int i = 0; i < count; ++i) {
+		v.emplace_back();
+		for (int j = 0; j <= i; ++j) {
+			v[i].map.insert(j, _Str(i * 1000 + j));
+		}
+	}
+	SSTD_CHECK(v.size() == static_cast<sstd::sizet>(count));
+	for (int i = 0; i < count; ++i) {
+		SSTD_CHECK(v[i].map.size() == static_cast<sstd::sizet>(i + 1));
+		for (int j = 0; j <= i; ++j) {
+			SSTD_CHECK(v[i].map.at(j) == _Str(i * 1000 + j));
+		}
+	}
+}
+
+template<typename _Map>
+struct _Just_Map {
+	_Map map;
+};
+
+int main() {
+	// Heap only, inline, and spilled out of the inline memory
+	_Test_Copy_Move<0>(0);
+	_Test_Copy_Move<0>(20);
+	_Test_Copy_Move<4>(0);
+	_Test_Copy_Move<4>(3);
+	_Test_Copy_Move<4>(20);
+
+	sstd::small_vector<int, 8> s;
+	for (int i = 0; i < 5; ++i) {
+		s.push_back(i);
+	}
+	sstd::small_vector<int, 8> t = std::move(s);
+	SSTD_CHECK(t.is_inline() && t.size() == 5 && t[4] == 4);
+
+	// A std::vector of vectors moves them when it grows, the heap memory of every element stays where it is
+	{
+		std::vector<sstd::vector<std::string> > v;
+		v.emplace_back();
+		v[0].push_back(_Str(0));
+		const std::string* first = v[0].data();
+		for (int i = 1; i < 100; ++i) {
+			v.emplace_back();
+			v[i].push_back(_Str(i));
+		}
+		SSTD_CHECK(v[0].data() == first);
+		SSTD_CHECK(v[0][0] == _Str(0) && v[99][0] == _Str(99));
+	}
+
+	// Vectors of tables, the maps opt into realloc ( see is_trivially_relocatable ), the wrapped one gets moved
+	{
+		sstd::vector<sstd::unordered_map<int, int> > v;
+		for (int i = 0; i < 20; ++i) {
+			v.emplace_back();
+			v[i].insert(i, i);
+		}
+		for (int i = 0; i < 20; ++i) {
+			SSTD_CHECK(v[i].size() == 1 && v[i].at(i) == i);
+		}
+	}
+	{
+		sstd::vector<_Just_Map<sstd::node_unordered_map<int, std::string> > > v;
+		_Test_Tables(v);
+	}
+	{
+		sstd::vector<_Named_Map> v;
+		_Test_Tables(v);
+	}
+	{
+		sstd::vector<_Named_Map, 4> v;
+		_Test_Tables(v);
+	}
+	{
+		std::vector<_Just_Map<sstd::unordered_map<int, std::string> > > v;
+		_Test_Tables(v);
+	}
+	{
+		sstd::vector<sstd::unordered_set<std::string> > v;
+		for (int i = 0; i < 30; ++i) {
+			v.emplace_back();
+			v[i].insert(_Str(i));
+		}
+		for (int i = 0; i < 30; ++i) {
+			SSTD_CHECK(v[i].size() == 1 && v[i].contains(_Str(i)));
+		}
+	}
+
+	std::printf("vector ok\n");
+	return 0;
+}
@@ -2,63 +2,62 @@
 #define SSTD_UNORDERED_MAP_INCLUDED
 
 #include "core.hpp"
+#include "Iterator.hpp"
+#include "hash.hpp"
+#include "hash_table.hpp"
+#include "relocate.hpp"
 
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <initializer_list>
+#include <iterator>
+#include <new>
 #include <utility>
 #include <ratio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 SSTD_BEGIN
 
 // -----------------------------------------
 //
-//   Hash functor
+//   Snapshots
 //
 // -----------------------------------------
 
-template<typename T>
-struct _Deault_Hash{
-	SSTD_INLINE SSTD_CONSTEXPR sizet operator()(const T& key) const {
-		return std::hash<T>::_Do_hash(key);
-	}
-};
-
-// -----------------------------------------
-//
-//   probing functors
-//
-// -----------------------------------------
-
-template<typename T, typename _Hash>
-struct _Linear_Prob {
-	SSTD_INLINE sizet operator()(const T& key, const sizet& i, const sizet& m, const _Hash hasher) const {
-		return (hasher(key) + i) % m;
-	}
-};
-template<typename T, int32 c1, int32 c2, typename _Hash>
-struct _Quadratic_Prob1 {
-	SSTD_INLINE sizet operator()(const T& key, const sizet& i, const sizet& m, const _Hash hasher) const {
-		return (hasher(key) + c1 * i + c2 * i * i) % m;
-	}
-};
-template<typename T, int32 c1, int32 c2, typename _Hash>
-struct _Quadratic_Prob2 {
-	SSTD_INLINE sizet operator()(const T& key, const sizet& i, const sizet& m, const _Hash hasher) const {
-		return (hasher(key) - pow(-1, i) * (i / 2) * (i / 2)) % m;
-	}
-};
-template<typename T, typename _Hash>
-struct _Double_Hash_Prob {
-	SSTD_INLINE sizet operator()(const T& key, const sizet& i, const sizet& m, const _Hash hasher) const {
-		const sizet _Hash_Res = hasher(key);					  
-		return (_Hash_Res + // First hash
-			i * ( _Hash_Res & 0xffffffffffffffff // i * second hash
-				| 0x0000000000000001 // Add this to make the second hash result an odd number
-			) 
-		) % m;
+// A file written by unordered_map::save looks like
+// [ header | control bytes | zero padding up to 64 bytes | slots ( _Storage::Write ) ]
+// It's only readable by a map with the same key, element, hash, probing and storage types ( on the same kind of machine )
+struct _Map_Snapshot_Header {
+	static SSTD_CONSTEXPR uint32 current_version = 1;
+
+	char magic[8];
+	uint32 version;
+	uint32 group_width;
+	uint64 sizet_size;
+	uint64 key_size;
+	uint64 elt_size;
+	uint64 slot_bytes;
+	uint64 capacity;
+	uint64 size;
+	uint64 tombstones;
+	// The seed of the saved map ( the cached hashes depend on it )
+	uint64 seed;
+
+	SSTD_INLINE static const char* Magic() noexcept {
+		return "SSTDMAP";
+	}
+	SSTD_INLINE static SSTD_CONSTEXPR sizet Slots_Offset(const sizet& capacity) noexcept {
+		return _Align_Up(sizeof(_Map_Snapshot_Header) + capacity, 64);
 	}
 };
 
+// Read only view of a saved map ( see mapped_unordered_map.hpp )
+template<typename _KeyT, typename _EltT, typename _Hash, typename _ProbT, typename _Storage>
+class mapped_unordered_map;
 
 // -----------------------------------------
 //
@@ -69,18 +68,26 @@ struct _Double_Hash_Prob {
 template<
 	typename _KeyT,
 	typename _EltT,
-	typename _Hash = _Deault_Hash<_KeyT>,
-	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash>
+	typename _Hash = hash<_KeyT>,
+	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash>,
+	typename _Storage = _Inline_Storage<_KeyT, _EltT>,
+	typename _AllocT = malloc_allocator
 >
 class _Unordered_Map_Iterator;
 template<
 	typename _KeyT,
 	typename _EltT,
-	typename _Hash = _Deault_Hash<_KeyT>,
-	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash>
+	typename _Hash = hash<_KeyT>,
+	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash>,
+	typename _Storage = _Inline_Storage<_KeyT, _EltT>,
+	typename _AllocT = malloc_allocator
 >
 class _Unordered_Map_Const_Iterator;
 
+// Shares the table internals ( see concurrent_unordered_map.hpp )
+template<typename _KeyT, typename _EltT, typename _Hash, typename _ProbT, sizet _Shards>
+class concurrent_unordered_map;
+
 // This is a completly different implementation than the one in std
 // std::unordered_map uses close addressing / chaining
 // This sstd::unordered_map uses open addressing
@@ -88,26 +95,54 @@ class _Unordered_Map_Const_Iterator;
 // when it comes to inserting
 // And performs 'slightly' better than std::unordered_map for other operations
 //
-// The capacity needs to be a power of 2
+// The full / empty / deleted state of the slots lives in a separate control byte array
+// Use _Group_Prob to probe the control bytes a whole SIMD group at a time ( swiss table style )
+//
+// The table itself ( probing, growing, seeding ) is _Hash_Table, see hash_table.hpp
+// The memory layout of the slots is up to _Storage ( see _Inline_Storage and _Split_Storage )
+// and the memory itself comes from _AllocT ( see allocator.hpp )
+//
+// The iterators return std::pair<const Key&, Element&> ( by value ), so a full scan copies nothing,
+// it->first / it->second go through a proxy holding that pair ( see _Arrow_Proxy ),
+// and stepping to the next element skips the empty slots a group of control bytes at a time
 
 template<
 	typename _KeyT,	// Key type
 	typename _EltT,		// Element type
-	typename _Hash = _Deault_Hash<_KeyT>, // Hash function 
-	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash> // probing function
+	typename _Hash = hash<_KeyT>, // Hash function 
+	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash>, // probing function
+	typename _Storage = _Inline_Storage<_KeyT, _EltT>, // slot layout
+	typename _AllocT = malloc_allocator // Where the memory comes from
 > 
-class unordered_map {
+class unordered_map : public _Hash_Table<_KeyT, _Hash, _ProbT, _Storage, _AllocT> {
 public:
-	friend class _Unordered_Map_Iterator<_KeyT, _EltT, _Hash, _ProbT>;
-	friend class _Unordered_Map_Const_Iterator<_KeyT, _EltT, _Hash, _ProbT>;
-	using iterator = _Unordered_Map_Iterator<_KeyT, _EltT, _Hash, _ProbT>;
-	using const_iterator = _Unordered_Map_Const_Iterator<_KeyT, _EltT, _Hash, _ProbT>;
+	friend class _Unordered_Map_Iterator<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>;
+	friend class _Unordered_Map_Const_Iterator<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>;
+	template<typename, typename, typename, typename, sizet>
+	friend class concurrent_unordered_map;
+	friend class mapped_unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage>;
+	using iterator = _Unordered_Map_Iterator<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>;
+	using const_iterator = _Unordered_Map_Const_Iterator<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>;
 private:
-	struct _Map_Element {
-		_KeyT key;
-		_EltT elt;
-		bool occupied = false;
-	};
+	using _Table = _Hash_Table<_KeyT, _Hash, _ProbT, _Storage, _AllocT>;
+	using _Table::m_slots;
+	using _Table::m_ctrl;
+	using _Table::m_capacity;
+	using _Table::m_size;
+	using _Table::m_tombstones;
+	using _Table::m_max_load_factor;
+	using _Table::m_seed;
+	using _Table::_Malloc_Table;
+	using _Table::_Reserve_Elements;
+	using _Table::_Find_Index;
+	using _Table::_Hash_Key;
+	using _Table::_Emplace_Hash;
+	using _Table::_Erase;
+	using _Table::_Erase_Index;
+	using _Table::_Find_Batch;
+	using _Table::_Key_At;
+	using _Table::_First_Full;
+	using _Table::_Next_Full;
 public:
 
 	// Default constructor
@@ -115,6 +150,12 @@ public:
 		_Malloc_Table(8); // just some random magic number
 	};
 
+	// Constructor that allocates from alloc
+	SSTD_EXPLICIT unordered_map(const _AllocT& alloc) :
+		_Table(alloc) {
+		_Malloc_Table(8);
+	}
+
 	// Constructor that initialize using a initializer list
 	// std::pair(Key, Element)
 	unordered_map(std::initializer_list<std::pair<_KeyT, _EltT> > list) {
@@ -125,110 +166,195 @@ public:
 		_Malloc_Table(actual_reserved_size);
 		_Load_Iterator(list.begin(), list.end());
 	}
-	
-	~unordered_map() {
-		// Destruct every destructable value
-		for (sizet i = 0; i < m_capacity; ++i) {
-			if (m_table[i].occupied) {
-				if (std::is_destructible<_KeyT>::value) {
-					m_table[i].key.~_KeyT();
-				}
-				if (std::is_destructible<_EltT>::value) {
-					m_table[i].elt.~_EltT();
-				}
-			}
-		}
-		free(m_table);
-		m_table = nullptr;
-		m_capacity = 0;
-		m_size = 0;
-	}
-
-	// Basically the destructor
-	SSTD_INLINE void clear() {
-		for (sizet i = 0; i < m_capacity; ++i) {
-			if (m_table[i].occupied) {
-				if (std::is_destructible<_KeyT>::value) {
-					m_table[i].key.~_KeyT();
-				}
-				if (std::is_destructible<_EltT>::value) {
-					m_table[i].elt.~_EltT();
-				}
-			}
-		}
-		free(m_table);
-		m_table = nullptr;
-		m_capacity = 0;
-		m_size = 0;
-	}
 
-	SSTD_INLINE void insert(const _KeyT& key, const _EltT& elt) {
-		_Insert(key, elt); 
-		// Not going to do anything to it yet
+	// Insert the element, or overwrite it if the key already exists
+	SSTD_INLINE std::pair<iterator, bool> insert(const _KeyT& key, const _EltT& elt) {
+		return _Insert_Or_Assign(key, elt);
+	}
+	SSTD_INLINE std::pair<iterator, bool> insert(const _KeyT& key, _EltT&& elt) {
+		return _Insert_Or_Assign(key, std::move(elt));
 	}
-	SSTD_INLINE void insert(const _KeyT& key, _EltT&& elt) {
-		_Insert(key, std::move(elt));
-		// Not going to do anything to it yet
+	SSTD_INLINE std::pair<iterator, bool> insert(const std::pair<_KeyT, _EltT>& pair) {
+		return _Insert_Or_Assign(pair.first, pair.second);
 	}
-	SSTD_INLINE void insert(const std::pair<_KeyT, _EltT>& pair) {
-		_Insert(pair.first, pair.second);
-		// Not going to do anything to it yet
+	SSTD_INLINE std::pair<iterator, bool> insert(std::pair<_KeyT, _EltT>&& pair) {
+		return _Insert_Or_Assign(std::move(pair.first), std::move(pair.second));
 	}
-	SSTD_INLINE void insert(const _KeyT& key) {
-		_Insert(key);
-		// Not going to do anything to it yet
+	// Insert ( or reset ) a default constructed element
+	// ( Use sstd::unordered_set if the element is just a placeholder )
+	SSTD_INLINE std::pair<iterator, bool> insert(const _KeyT& key) {
+		return _Insert_Or_Assign(key, _EltT());
 	}
 
-	SSTD_INLINE void erase(const _KeyT& key) {
-		_Erase(key);
+	// Construct the key and the element directly into the table.
+	// The first argument is the key, the rest are passed to the constructor of the element
+	// Nothing gets constructed if the key already exists
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> emplace(_KeyArg&& key, _Args&& ...args) {
+		return _Try_Emplace(std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
 	}
 
-	// Malloc / Realloc the additional _size
-	SSTD_INLINE void reserve(const sizet& _size) {
-		if (m_table == nullptr) {
-			_Malloc_Table(_size);
-		}
-		else {
-			_Realloc_Table(m_capacity + _size);
-		}
+	// Same as emplace, but the key is always a _KeyT
+	template<typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> try_emplace(const _KeyT& key, _Args&& ...args) {
+		return _Try_Emplace(key, std::forward<_Args>(args)...);
+	}
+	template<typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> try_emplace(_KeyT&& key, _Args&& ...args) {
+		return _Try_Emplace(std::move(key), std::forward<_Args>(args)...);
 	}
 
-	SSTD_INLINE SSTD_CONSTEXPR sizet size() const noexcept {
-		return m_size;
+	// Assign elt if the key already exists, otherwise construct it in place
+	template<typename _TE>
+	SSTD_INLINE std::pair<iterator, bool> insert_or_assign(const _KeyT& key, _TE&& elt) {
+		return _Insert_Or_Assign(key, std::forward<_TE>(elt));
 	}
-	SSTD_INLINE SSTD_CONSTEXPR sizet capacity() const noexcept {
-		return m_capacity;
+	template<typename _TE>
+	SSTD_INLINE std::pair<iterator, bool> insert_or_assign(_KeyT&& key, _TE&& elt) {
+		return _Insert_Or_Assign(std::move(key), std::forward<_TE>(elt));
 	}
-	SSTD_INLINE SSTD_CONSTEXPR sizet empty() const noexcept {
-		return m_size == 0;
+
+	// Returns how many elements got erased ( 0 or 1 )
+	SSTD_INLINE sizet erase(const _KeyT& key) {
+		return _Erase(key);
 	}
 
 	// Construct a empty value into the table if the key doesn't exist
 	SSTD_INLINE _EltT& operator[](const _KeyT& key) {
-		//_Print();
-		iterator ptr = _Search(key);
-		if (ptr != end()) {
-			return m_table[ptr.m_ind].elt;
-		}
-		iterator itr = _Insert(key, _EltT());
-		return m_table[itr.m_ind].elt;
+		return _Elt_At(_Try_Emplace(key).first.m_ind);
+	}
+	SSTD_INLINE _EltT& operator[](_KeyT&& key) {
+		return _Elt_At(_Try_Emplace(std::move(key)).first.m_ind);
 	}
 
 	// Straight up return
 	SSTD_INLINE const _EltT& operator[](const _KeyT& key) const noexcept {
-		return m_table[_Search(key).m_ind].elt;
+		return _Elt_At(_Search(key).m_ind);
+	}
+
+	// Lookups
+	// The templated versions take any key-like type, as long as the hash functor is transparent ( see hash.hpp )
+	SSTD_INLINE iterator find(const _KeyT& key) {
+		return iterator(this, _Find_Index(key));
+	}
+	SSTD_INLINE const_iterator find(const _KeyT& key) const {
+		return const_iterator(this, _Find_Index(key));
+	}
+	template<typename _KeyLike, typename _H = _Hash, typename = std::enable_if_t<_Is_Transparent<_H>::value> >
+	SSTD_INLINE iterator find(const _KeyLike& key) {
+		return iterator(this, _Find_Index(key));
+	}
+	template<typename _KeyLike, typename _H = _Hash, typename = std::enable_if_t<_Is_Transparent<_H>::value> >
+	SSTD_INLINE const_iterator find(const _KeyLike& key) const {
+		return const_iterator(this, _Find_Index(key));
+	}
+
+	SSTD_INLINE bool contains(const _KeyT& key) const {
+		return _Find_Index(key) != m_capacity;
+	}
+	template<typename _KeyLike, typename _H = _Hash, typename = std::enable_if_t<_Is_Transparent<_H>::value> >
+	SSTD_INLINE bool contains(const _KeyLike& key) const {
+		return _Find_Index(key) != m_capacity;
+	}
+
+	SSTD_INLINE sizet count(const _KeyT& key) const {
+		return contains(key);
+	}
+	template<typename _KeyLike, typename _H = _Hash, typename = std::enable_if_t<_Is_Transparent<_H>::value> >
+	SSTD_INLINE sizet count(const _KeyLike& key) const {
+		return contains(key);
 	}
 
-	// Mantain this below max_load_factor
-	SSTD_INLINE SSTD_CONSTEXPR Decimal load_factor() const {
-		return static_cast<Decimal>(m_size) / (m_capacity ? m_capacity : 1);
+	// Throws if the key doesn't exist
+	SSTD_INLINE _EltT& at(const _KeyT& key) {
+		return _Elt_At(_Check_Key(_Find_Index(key)));
+	}
+	SSTD_INLINE const _EltT& at(const _KeyT& key) const {
+		return _Elt_At(_Check_Key(_Find_Index(key)));
+	}
+	template<typename _KeyLike, typename _H = _Hash, typename = std::enable_if_t<_Is_Transparent<_H>::value> >
+	SSTD_INLINE _EltT& at(const _KeyLike& key) {
+		return _Elt_At(_Check_Key(_Find_Index(key)));
+	}
+	template<typename _KeyLike, typename _H = _Hash, typename = std::enable_if_t<_Is_Transparent<_H>::value> >
+	SSTD_INLINE const _EltT& at(const _KeyLike& key) const {
+		return _Elt_At(_Check_Key(_Find_Index(key)));
+	}
+
+	// Insert ( or overwrite ) every std::pair(Key, Element) in [first, last)
+	// The table is sized once up front, instead of growing again and again in the middle of the inserts
+	template<typename _Iter>
+	SSTD_INLINE void insert_bulk(_Iter first, _Iter last) {
+		if constexpr (std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<_Iter>::iterator_category>::value) {
+			_Reserve_Elements(m_size + static_cast<sizet>(std::distance(first, last)));
+		}
+		_Load_Iterator(first, last);
+	}
+
+	// Look up count keys at once
+	// out[i] points to the element of keys[i], or is nullptr if the key doesn't exist
+	// ( The lookups of a batch overlap their cache misses, see _Hash_Table::_Find_Batch,
+	// how much that buys over a loop of find depends on the machine and the table, bench/find_batch.cpp measures it )
+	SSTD_INLINE void find_batch(const _KeyT* keys, const sizet& count, _EltT** out) {
+		_Find_Batch(keys, count, [&](const sizet& i, const sizet& ind) {
+			out[i] = ind == m_capacity ? nullptr : &_Elt_At(ind);
+		});
+	}
+	SSTD_INLINE void find_batch(const _KeyT* keys, const sizet& count, const _EltT** out) const {
+		_Find_Batch(keys, count, [&](const sizet& i, const sizet& ind) {
+			out[i] = ind == m_capacity ? nullptr : &_Elt_At(ind);
+		});
+	}
+
+	// Write the table to path as it is in memory, so open_mapped can serve lookups straight from the file
+	// Only for trivially copyable keys and elements, in a flat storage
+	// Throws std::runtime_error if the file can't be written
+	SSTD_INLINE void save(const char* path) const {
+		static_assert(std::is_trivially_copyable<_KeyT>::value && std::is_trivially_copyable<_EltT>::value,
+			"Only maps with trivially copyable keys and elements can be saved");
+		static_assert(_Storage::flat, "Only flat storages can be saved");
+		if (this->rehashing()) {
+			throw std::runtime_error("Can't save an unordered map in the middle of an incremental rehash ( see finish_rehash )");
+		}
+
+		_Map_Snapshot_Header header = {};
+		std::memcpy(header.magic, _Map_Snapshot_Header::Magic(), sizeof(header.magic));
+		header.version = _Map_Snapshot_Header::current_version;
+		header.group_width = static_cast<uint32>(_ProbT::group_width);
+		header.sizet_size = sizeof(sizet);
+		header.key_size = sizeof(_KeyT);
+		header.elt_size = sizeof(_EltT);
+		header.slot_bytes = _Storage::Bytes(m_capacity);
+		header.capacity = m_capacity;
+		header.size = m_size;
+		header.tombstones = m_tombstones;
+		header.seed = m_seed;
+
+		std::FILE* file = std::fopen(path, "wb");
+		if (file == nullptr) {
+			throw std::runtime_error("Failed to open the unordered map snapshot for writing");
+		}
+		// ( A cleared map has no table at all )
+		const bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+			&& (m_capacity == 0 || std::fwrite(m_ctrl, sizeof(_Ctrl_T), m_capacity, file) == m_capacity)
+			&& _Write_Padding(file, _Map_Snapshot_Header::Slots_Offset(m_capacity) - sizeof(header) - m_capacity)
+			&& (m_capacity == 0 || m_slots.Write(file, m_capacity));
+		if (std::fclose(file) != 0 || !ok) {
+			throw std::runtime_error("Failed to write the unordered map snapshot");
+		}
+	}
+
+	// Map a file written by save, read only
+	// Nothing gets deserialized, the lookups probe the mapped file directly ( needs mapped_unordered_map.hpp )
+	SSTD_INLINE static mapped_unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage> open_mapped(const char* path) {
+		return mapped_unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage>(path);
 	}
 
 	SSTD_INLINE SSTD_CONSTEXPR iterator begin() noexcept {
-		return iterator(this, 0);
+		return iterator(this, _First_Full());
 	}
 	SSTD_INLINE SSTD_CONSTEXPR const_iterator begin() const noexcept {
-		return const_iterator(this, 0);
+		return const_iterator(this, _First_Full());
 	}
 	SSTD_INLINE SSTD_CONSTEXPR iterator end() noexcept {
 		return iterator(this, m_capacity);
@@ -237,191 +363,94 @@ public:
 		return const_iterator(this, m_capacity);
 	}
 
-	SSTD_INLINE SSTD_CONSTEXPR iterator cbegin() noexcept {
-		return const_iterator(this, 0);
+	SSTD_INLINE SSTD_CONSTEXPR const_iterator cbegin() const noexcept {
+		return const_iterator(this, _First_Full());
 	}
-	SSTD_INLINE SSTD_CONSTEXPR iterator cend() noexcept {
+	SSTD_INLINE SSTD_CONSTEXPR const_iterator cend() const noexcept {
 		return const_iterator(this, m_capacity);
 	}
 private:
-	_Map_Element* m_table = nullptr;
-
-	const _Hash m_Hasher;
-	const _ProbT m_prob;
-
-	sizet m_size = 0;
-	sizet m_capacity = 0;
-
-	Decimal m_max_load_factor = 0.5;
-
-	SSTD_INLINE void _Malloc_Table(const sizet& memsize) {
-		m_capacity = memsize;
-		m_table = (_Map_Element*)malloc(sizeof(_Map_Element) * m_capacity);
-		for (sizet i = 0; i < m_capacity; ++i) {
-			m_table[i].occupied = false;
+	// Construct the element in place, only if the key doesn't exist yet
+	// The key is moved in if it's an rvalue, and the element is constructed from args
+	// Returns the iterator to the element with the key, and whether it was inserted
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> _Try_Emplace(_KeyArg&& key, _Args&& ...args) {
+		const sizet hash = _Hash_Key(key);
+		return _Try_Emplace_Hash(hash, std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+	}
+	// The same, with the hash ( _Hash_Key ) already known
+	template<typename _KeyArg, typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> _Try_Emplace_Hash(const sizet& hash, _KeyArg&& key, _Args&& ...args) {
+		const std::pair<sizet, bool> res = _Emplace_Hash(hash, std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+		return { iterator(this, res.first), res.second };
+	}
+
+	// Assign to the element if the key exists, otherwise construct it in place
+	template<typename _KeyArg, typename _TE>
+	SSTD_INLINE std::pair<iterator, bool> _Insert_Or_Assign(_KeyArg&& key, _TE&& elt) {
+		const sizet hash = _Hash_Key(key);
+		return _Insert_Or_Assign_Hash(hash, std::forward<_KeyArg>(key), std::forward<_TE>(elt));
+	}
+	template<typename _KeyArg, typename _TE>
+	SSTD_INLINE std::pair<iterator, bool> _Insert_Or_Assign_Hash(const sizet& hash, _KeyArg&& key, _TE&& elt) {
+		std::pair<iterator, bool> res = _Try_Emplace_Hash(hash, std::forward<_KeyArg>(key), std::forward<_TE>(elt));
+		if (!res.second && res.first != end()) {
+			_Elt_At(res.first.m_ind) = std::forward<_TE>(elt);
 		}
+		return res;
 	}
 
-	SSTD_INLINE void _Realloc_Table(const sizet& new_size) {
-		_Map_Element* tmp = (_Map_Element*)realloc(m_table, sizeof(_Map_Element) * new_size);
-
-		// Handle situations if there aren't enough memory to extend
-		if (tmp == nullptr) {
-			tmp = (_Map_Element*)malloc(sizeof(_Map_Element) * new_size);
-			std::copy(m_table, m_table + m_capacity, tmp);
-			// Has already copyed the old data to the new memory, so the old memory is useless
-			free(m_table);
-		}
-		m_table = tmp;
-		for (sizet i = m_capacity; i < new_size; ++i) {
-			m_table[i].occupied = false;
-		}
-		m_capacity = new_size;
+	SSTD_INLINE iterator _Search(const _KeyT& key) {
+		return iterator(this, _Find_Index(key));
 	}
 
-	template<typename _TE>
-	SSTD_INLINE iterator _Insert(const _KeyT& key, _TE&& elt) {
-		if (m_table == nullptr) {
-			_Malloc_Table(4);
-			// Yet another magic number
-			// ( Just kidding, set it to 4 so it will not trigger the reallocation until the 3rd insert )
-		}
-		// Mantain load_factor below the max_load_factor
-		if (load_factor() >= m_max_load_factor) {
-			_Realloc_Table(m_capacity * 2);
-		}
-		sizet i = 0;
-		while (i != m_capacity) {
-			// Get probing index
-			const sizet ind = m_prob(key, i, m_capacity, m_Hasher);
-			// That block is empty ( is available )
-			if (!m_table[ind].occupied) {
-				++m_size;
-				// Acquire it
-				m_table[ind].occupied = true;
-
-				// Construct it
-				m_table[ind].key = key;
-				new (&m_table[ind].elt) _EltT(elt);
-
-				return iterator(this, ind);
-			}
-			// Or that block has the same key
-			else if (m_table[ind].key == key) {
-				// Construct it
-				new (&m_table[ind].elt) _EltT(std::move(elt));
-
-				return iterator(this, ind);
-			}
-			++i;
-		}
-		// The table is full ( which won't happen, or something is really REALLY wrong)
-		return end();
+	// A const version that returns const_iterator
+	SSTD_INLINE const_iterator _Search(const _KeyT key) const {
+		return const_iterator(this, _Find_Index(key));
 	}
 
-	// Insert default constructor
-	SSTD_INLINE iterator _Insert(const _KeyT& key) {
-		if (m_table == nullptr) {
-			_Malloc_Table(4);
-			// Yet another magic number
-			// ( Just kidding, set it to 4 so it will not trigger the reallocation until the 3rd insert )
-		}
-		// Mantain load_factor below the max_load_factor
-		if (load_factor() >= m_max_load_factor) {
-			_Realloc_Table(m_capacity * 2);
-		}
-		sizet i = 0;
-		while (i != m_capacity) {
-			// Get probing index
-			const sizet ind = m_prob(key, i, m_capacity, m_Hasher);
-			// That block is empty ( is available )
-			if (!m_table[ind].occupied) {
-				++m_size;
-				// Acquire it
-				m_table[ind].occupied = true;
-
-				// Construct it
-				m_table[ind].key = key;
-				new (&m_table[ind].elt) _EltT();
-
-				return iterator(this, ind);
-			}
-			// Or that block has the same key
-			else if (m_table[ind].key == key) {
-				// Construct it
-				new (&m_table[ind].elt) _EltT();
-
-				return iterator(this, ind);
-			}
-			++i;
-		}
-		// The table is full ( which won't happen, or something is really REALLY wrong)
-		return end();
+	// The element in slot ind ( see _Hash_Table::_Key_At )
+	SSTD_INLINE _EltT& _Elt_At(const sizet& ind) const noexcept {
+		return ind < m_capacity ? m_slots.Elt(ind) : this->m_old_slots.Elt(ind - m_capacity - 1);
 	}
 
-	SSTD_INLINE iterator _Search(const _KeyT& key) {
-		sizet i = 0;
-		while (i != m_capacity) {
-			// Get probing index
-			const sizet ind = m_prob(key, i, m_capacity, m_Hasher);
-			if (m_table[ind].key == key) {
-				return iterator(this, ind);
-			}
-			else if (!m_table[ind].occupied) {
-				return end();
-			}
-			++i;
-		}
-
-		// Didn't find
-		return end();
+	// The slot an iterator points to
+	SSTD_INLINE static sizet _Index_Of(const iterator& itr) noexcept {
+		return itr.m_ind;
 	}
 
-	// A const version that returns const_iterator
-	SSTD_INLINE const_iterator _Search(const _KeyT key) const {
-		sizet i = 0;
-		while (i != m_capacity) {
-			const sizet ind = m_prob(key, i, m_capacity, m_Hasher);
-			if (m_table[ind].key == key) {
-				return const_iterator(this, ind);
-			}
-			else if (!m_table[ind].occupied) {
-				return end();
-			}
-			++i;
-		}
-		return end();
-	}
-
-	// Erase the key
-	SSTD_INLINE void _Erase(const _KeyT& key) {
-		sizet i = 0;
-		while (i != m_capacity) {
-			const sizet ind = m_prob(key, i, m_capacity, m_Hasher);
-			if (m_table[ind].key == key && m_table[ind].occupied) {
-				m_table[ind].occupied = false;
-				if (std::is_destructible<_EltT>::value) {
-					m_table[ind].elt.~_EltT();
-				}
-				if (std::is_destructible<_KeyT>::value) {
-					m_table[ind].key.~_KeyT();
-				}
-				--m_size;
-				return;
-			}
-			++i;
+	SSTD_INLINE sizet _Check_Key(const sizet& ind) const {
+		if (ind == m_capacity) {
+			throw std::out_of_range("Unordered map key not found");
 		}
+		return ind;
 	}
 
 	// Load an iterator into the table
 	template<typename _Iter>
 	SSTD_INLINE void _Load_Iterator(_Iter _Begin, _Iter _End) {
 		for (; _Begin != _End; ++_Begin) {
-			_Insert(_Begin->first, _Begin->second);
+			_Insert_Or_Assign(_Begin->first, _Begin->second);
 		}
 	}
 };
 
+// A sstd::unordered_map whose keys and elements never move ( see _Node_Storage )
+// References ( and pointers ) to them are only invalidated by erasing that key,
+// and growing the table only moves pointers around
+template<
+	typename _KeyT,
+	typename _EltT,
+	typename _Hash = hash<_KeyT>,
+	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash>,
+	typename _AllocT = malloc_allocator
+>
+using node_unordered_map = unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Node_Storage<_KeyT, _EltT, _AllocT>, _AllocT>;
+
+// Nothing points into a map ( the table and the nodes are on the heap ), so a vector of maps can grow with realloc
+template<typename _KeyT, typename _EltT, typename _Hash, typename _ProbT, typename _Storage, typename _AllocT>
+struct is_trivially_relocatable<unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT> > : _Table_Relocatable<_Hash, _ProbT, _Storage, _AllocT> {};
+
 // -----------------------------------------
 //
 //   Forward Iterator
@@ -432,28 +461,46 @@ template<
 	typename _KeyT,
 	typename _EltT,
 	typename _Hash,
-	typename _ProbT
+	typename _ProbT,
+	typename _Storage,
+	typename _AllocT
 >
-class _Unordered_Map_Iterator : public forward_iterator<std::pair<_KeyT, _EltT> > {
-	friend class unordered_map<_KeyT, _EltT, _Hash, _ProbT>;
+class _Unordered_Map_Iterator : public forward_iterator<std::pair<const _KeyT, _EltT> > {
+	friend class unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>;
+	friend class _Unordered_Map_Const_Iterator<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>;
 public:
-	_Unordered_Map_Iterator(unordered_map<_KeyT, _EltT, _Hash, _ProbT>* _map, sizet ind) :
+	using value_type = std::pair<const _KeyT, _EltT>;
+	// A pair of references into the slot, nothing gets copied
+	using reference = std::pair<const _KeyT&, _EltT&>;
+	using pointer = _Arrow_Proxy<reference>;
+
+	_Unordered_Map_Iterator(unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>* _map, sizet ind) :
 		m_map(_map), m_ind(ind) {
 
 	}
 
 	SSTD_INLINE _Unordered_Map_Iterator& operator++() noexcept {
-		do { this->m_ind++; } while (m_ind < m_map->m_capacity && m_map->m_table[m_ind].available);
+		this->m_ind = m_map->_Next_Full(m_ind + 1);
 		return *this;
 	}
 	SSTD_INLINE _Unordered_Map_Iterator operator++(int) noexcept {
 		_Unordered_Map_Iterator tmp = *this;
-		do { this->m_ind++; } while (m_ind < m_map->m_capacity && !m_map->m_table[m_ind].occupied);
+		this->m_ind = m_map->_Next_Full(m_ind + 1);
 		return tmp;
 	}
 
-	SSTD_INLINE std::pair<_KeyT, _EltT> operator*() noexcept {
-		return { this->m_map->m_table[m_ind].key, this->m_map->m_table[m_ind].elt };
+	SSTD_INLINE reference operator*() const noexcept {
+		return { key(), value() };
+	}
+	SSTD_INLINE pointer operator->() const noexcept {
+		return { **this };
+	}
+
+	SSTD_INLINE const _KeyT& key() const noexcept {
+		return this->m_map->_Key_At(m_ind);
+	}
+	SSTD_INLINE _EltT& value() const noexcept {
+		return this->m_map->_Elt_At(m_ind);
 	}
 
 	SSTD_INLINE bool operator==(const _Unordered_Map_Iterator& other) const noexcept {
@@ -464,7 +511,7 @@ public:
 		return this->m_map != other.m_map || this->m_ind != other.m_ind;
 	}
 private:
-	unordered_map<_KeyT, _EltT, _Hash, _ProbT>* m_map;
+	unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>* m_map;
 	sizet m_ind;
 };
 
@@ -478,33 +525,49 @@ template<
 	typename _KeyT,
 	typename _EltT,
 	typename _Hash,
-	typename _ProbT
+	typename _ProbT,
+	typename _Storage,
+	typename _AllocT
 >
-class _Unordered_Map_Const_Iterator : public const_forward_iterator<std::pair<_KeyT, _EltT>> {
-	friend class unordered_map<_KeyT, _EltT, _Hash, _ProbT>;
-	friend class _Unordered_Map_Iterator<_KeyT, _EltT, _Hash, _ProbT>;
+class _Unordered_Map_Const_Iterator : public const_forward_iterator<std::pair<const _KeyT, _EltT>> {
+	friend class unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>;
+	friend class _Unordered_Map_Iterator<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>;
 public:
-	_Unordered_Map_Const_Iterator(const unordered_map<_KeyT, _EltT, _Hash, _ProbT>* _map, sizet ind) :
+	using value_type = std::pair<const _KeyT, _EltT>;
+	using reference = std::pair<const _KeyT&, const _EltT&>;
+	using pointer = _Arrow_Proxy<reference>;
+
+	_Unordered_Map_Const_Iterator(const unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>* _map, sizet ind) :
 		m_map(_map), m_ind(ind) {
 
 	}
-	_Unordered_Map_Const_Iterator(_Unordered_Map_Iterator<_KeyT, _EltT, _Hash, _ProbT> itr) :
+	_Unordered_Map_Const_Iterator(_Unordered_Map_Iterator<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT> itr) :
 		m_map(itr.m_map), m_ind(itr.m_ind) {
 
 	}
 
 	SSTD_INLINE _Unordered_Map_Const_Iterator& operator++() noexcept {
-		do { this->m_ind++; } while (m_ind < m_map->m_capacity && m_map->m_table[m_ind].available);
+		this->m_ind = m_map->_Next_Full(m_ind + 1);
 		return *this;
 	}
 	SSTD_INLINE _Unordered_Map_Const_Iterator operator++(int) noexcept {
 		_Unordered_Map_Const_Iterator tmp = *this;
-		do { this->m_ind++; } while (m_ind < m_map->m_capacity && !m_map->m_table[m_ind].occupied);
+		this->m_ind = m_map->_Next_Full(m_ind + 1);
 		return tmp;
 	}
 
-	SSTD_INLINE std::pair<_KeyT, _EltT> operator*() const noexcept {
-		return { this->m_map->m_table[m_ind].key, this->m_map->m_table[m_ind].elt };
+	SSTD_INLINE reference operator*() const noexcept {
+		return { key(), value() };
+	}
+	SSTD_INLINE pointer operator->() const noexcept {
+		return { **this };
+	}
+
+	SSTD_INLINE const _KeyT& key() const noexcept {
+		return this->m_map->_Key_At(m_ind);
+	}
+	SSTD_INLINE const _EltT& value() const noexcept {
+		return this->m_map->_Elt_At(m_ind);
 	}
 
 	SSTD_INLINE bool operator==(const _Unordered_Map_Const_Iterator& other) const noexcept {
@@ -515,7 +578,7 @@ public:
 		return this->m_map != other.m_map || this->m_ind != other.m_ind;
 	}
 private:
-	const unordered_map<_KeyT, _EltT, _Hash, _ProbT>* m_map;
+	const unordered_map<_KeyT, _EltT, _Hash, _ProbT, _Storage, _AllocT>* m_map;
 	sizet m_ind;
 };
 
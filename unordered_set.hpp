@@ -0,0 +1,223 @@
+#ifndef SSTD_UNORDERED_SET_INCLUDED
+#define SSTD_UNORDERED_SET_INCLUDED
+
+#include "core.hpp"
+#include "Iterator.hpp"
+#include "hash.hpp"
+#include "hash_table.hpp"
+#include "relocate.hpp"
+
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+SSTD_BEGIN
+
+template<typename _KeyT, typename _Hash, typename _ProbT, typename _Storage, typename _AllocT>
+class _Unordered_Set_Iterator;
+
+// A sstd::unordered_map without the elements
+// Same table underneath ( see _Hash_Table ), with the same probing functors, seeding, reserve and batched lookups,
+// but a slot only holds the key and its hash ( see _Key_Storage ), instead of paying for a placeholder element
+//
+// The keys can't be modified in place ( that would break their hash ), so every iterator is a const one
+
+template<
+	typename _KeyT,	// Key type
+	typename _Hash = hash<_KeyT>, // Hash function
+	typename _ProbT = _Double_Hash_Prob<_KeyT, _Hash>, // probing function
+	typename _Storage = _Key_Storage<_KeyT>, // slot layout
+	typename _AllocT = malloc_allocator // Where the memory comes from
+>
+class unordered_set : public _Hash_Table<_KeyT, _Hash, _ProbT, _Storage, _AllocT> {
+public:
+	friend class _Unordered_Set_Iterator<_KeyT, _Hash, _ProbT, _Storage, _AllocT>;
+	using iterator = _Unordered_Set_Iterator<_KeyT, _Hash, _ProbT, _Storage, _AllocT>;
+	using const_iterator = iterator;
+private:
+	using _Table = _Hash_Table<_KeyT, _Hash, _ProbT, _Storage, _AllocT>;
+	using _Table::m_slots;
+	using _Table::m_ctrl;
+	using _Table::m_capacity;
+	using _Table::m_size;
+	using _Table::m_max_load_factor;
+	using _Table::_Malloc_Table;
+	using _Table::_Reserve_Elements;
+	using _Table::_Find_Index;
+	using _Table::_Hash_Key;
+	using _Table::_Emplace_Hash;
+	using _Table::_Erase;
+	using _Table::_Key_At;
+	using _Table::_First_Full;
+	using _Table::_Next_Full;
+	using _Table::_Find_Batch;
+public:
+
+	// Default constructor
+	unordered_set() {
+		_Malloc_Table(8);
+	}
+
+	// Constructor that allocates from alloc
+	SSTD_EXPLICIT unordered_set(const _AllocT& alloc) :
+		_Table(alloc) {
+		_Malloc_Table(8);
+	}
+
+	// Constructor that initialize using a initializer list
+	unordered_set(std::initializer_list<_KeyT> list) {
+		_Malloc_Table(static_cast<sizet>(list.size() / m_max_load_factor) + 1);
+		_Load_Iterator(list.begin(), list.end());
+	}
+
+	// Returns the iterator to the key, and whether it's new
+	SSTD_INLINE std::pair<iterator, bool> insert(const _KeyT& key) {
+		return _Insert(key);
+	}
+	SSTD_INLINE std::pair<iterator, bool> insert(_KeyT&& key) {
+		return _Insert(std::move(key));
+	}
+
+	// Construct the key from args
+	// ( It's constructed before the lookup, because it needs to be hashed )
+	template<typename ... _Args>
+	SSTD_INLINE std::pair<iterator, bool> emplace(_Args&& ...args) {
+		return _Insert(_KeyT(std::forward<_Args>(args)...));
+	}
+
+	// Insert every key in [first, last)
+	// The table is sized once up front, instead of growing again and again in the middle of the inserts
+	template<typename _Iter>
+	SSTD_INLINE void insert_bulk(_Iter first, _Iter last) {
+		if constexpr (std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<_Iter>::iterator_category>::value) {
+			_Reserve_Elements(m_size + static_cast<sizet>(std::distance(first, last)));
+		}
+		_Load_Iterator(first, last);
+	}
+
+	// Returns how many keys got erased ( 0 or 1 )
+	SSTD_INLINE sizet erase(const _KeyT& key) {
+		return _Erase(key);
+	}
+
+	// Lookups
+	// The templated versions take any key-like type, as long as the hash functor is transparent ( see hash.hpp )
+	SSTD_INLINE iterator find(const _KeyT& key) const {
+		return iterator(this, _Find_Index(key));
+	}
+	template<typename _KeyLike, typename _H = _Hash, typename = std::enable_if_t<_Is_Transparent<_H>::value> >
+	SSTD_INLINE iterator find(const _KeyLike& key) const {
+		return iterator(this, _Find_Index(key));
+	}
+
+	SSTD_INLINE bool contains(const _KeyT& key) const {
+		return _Find_Index(key) != m_capacity;
+	}
+	template<typename _KeyLike, typename _H = _Hash, typename = std::enable_if_t<_Is_Transparent<_H>::value> >
+	SSTD_INLINE bool contains(const _KeyLike& key) const {
+		return _Find_Index(key) != m_capacity;
+	}
+
+	SSTD_INLINE sizet count(const _KeyT& key) const {
+		return contains(key);
+	}
+	template<typename _KeyLike, typename _H = _Hash, typename = std::enable_if_t<_Is_Transparent<_H>::value> >
+	SSTD_INLINE sizet count(const _KeyLike& key) const {
+		return contains(key);
+	}
+
+	// Look up count keys at once, out[i] is whether keys[i] exists
+	// ( The lookups of a batch overlap their cache misses, see _Hash_Table::_Find_Batch )
+	SSTD_INLINE void find_batch(const _KeyT* keys, const sizet& count, bool* out) const {
+		_Find_Batch(keys, count, [&](const sizet& i, const sizet& ind) {
+			out[i] = ind != m_capacity;
+		});
+	}
+
+	SSTD_INLINE iterator begin() const noexcept {
+		return iterator(this, _First_Full());
+	}
+	SSTD_INLINE iterator end() const noexcept {
+		return iterator(this, m_capacity);
+	}
+	SSTD_INLINE iterator cbegin() const noexcept {
+		return begin();
+	}
+	SSTD_INLINE iterator cend() const noexcept {
+		return end();
+	}
+private:
+	template<typename _KeyArg>
+	SSTD_INLINE std::pair<iterator, bool> _Insert(_KeyArg&& key) {
+		const sizet hash = _Hash_Key(key);
+		const std::pair<sizet, bool> res = _Emplace_Hash(hash, std::forward<_KeyArg>(key));
+		return { iterator(this, res.first), res.second };
+	}
+
+	// Load an iterator into the table
+	template<typename _Iter>
+	SSTD_INLINE void _Load_Iterator(_Iter _Begin, _Iter _End) {
+		for (; _Begin != _End; ++_Begin) {
+			_Insert(*_Begin);
+		}
+	}
+};
+
+// Same as the map, nothing points into a set
+template<typename _KeyT, typename _Hash, typename _ProbT, typename _Storage, typename _AllocT>
+struct is_trivially_relocatable<unordered_set<_KeyT, _Hash, _ProbT, _Storage, _AllocT> > : _Table_Relocatable<_Hash, _ProbT, _Storage, _AllocT> {};
+
+// -----------------------------------------
+//
+//   Const Forward Iterator
+//
+// -----------------------------------------
+
+template<
+	typename _KeyT,
+	typename _Hash,
+	typename _ProbT,
+	typename _Storage,
+	typename _AllocT
+>
+class _Unordered_Set_Iterator : public const_forward_iterator<_KeyT> {
+	friend class unordered_set<_KeyT, _Hash, _ProbT, _Storage, _AllocT>;
+public:
+	_Unordered_Set_Iterator(const unordered_set<_KeyT, _Hash, _ProbT, _Storage, _AllocT>* _set, sizet ind) :
+		m_set(_set), m_ind(ind) {
+
+	}
+
+	SSTD_INLINE _Unordered_Set_Iterator& operator++() noexcept {
+		m_ind = m_set->_Next_Full(m_ind + 1);
+		return *this;
+	}
+	SSTD_INLINE _Unordered_Set_Iterator operator++(int) noexcept {
+		_Unordered_Set_Iterator tmp = *this;
+		m_ind = m_set->_Next_Full(m_ind + 1);
+		return tmp;
+	}
+
+	SSTD_INLINE const _KeyT& operator*() const noexcept {
+		return this->m_set->_Key_At(m_ind);
+	}
+	SSTD_INLINE const _KeyT* operator->() const noexcept {
+		return &this->m_set->_Key_At(m_ind);
+	}
+
+	SSTD_INLINE bool operator==(const _Unordered_Set_Iterator& other) const noexcept {
+		return this->m_set == other.m_set && this->m_ind == other.m_ind;
+	}
+
+	SSTD_INLINE bool operator!=(const _Unordered_Set_Iterator& other) const noexcept {
+		return this->m_set != other.m_set || this->m_ind != other.m_ind;
+	}
+private:
+	const unordered_set<_KeyT, _Hash, _ProbT, _Storage, _AllocT>* m_set;
+	sizet m_ind;
+};
+
+SSTD_END
+
+#endif
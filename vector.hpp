@@ -3,6 +3,8 @@
 
 #include "core.hpp"
 #include "Iterator.hpp"
+#include "allocator.hpp"
+#include "relocate.hpp"
 #include "Debug/Debug.hpp"
 
 #include <initializer_list>
@@ -10,85 +12,147 @@
 #include <stdlib.h>
 #include <malloc.h>
 #include <algorithm>
-#include <xmemory>
+#include <cstring>
 #include <new>
+#include <stdexcept>
+#include <type_traits>
 #include <utility>
 
 SSTD_BEGIN
 
-template<typename T>
+template<typename T, sizet _Inline, typename _AllocT>
 class _Vector_Iterator;
-template<typename T>
+template<typename T, sizet _Inline, typename _AllocT>
 class _Vector_Reverse_Iterator;
-template<typename T>
+template<typename T, sizet _Inline, typename _AllocT>
 class _Vector_Const_Iterator;
-template<typename T>
+template<typename T, sizet _Inline, typename _AllocT>
 class _Vector_Const_Reverse_Iterator;
 
 // This vector clone made a little change in the way it allocates memory
 // The std::vector uses new / delete aka the c++ allocator way to allocate memory
 // This sstd::vector uses malloc / realloc to get that sweet performance buff
+// ( realloc and memmove only move bytes, so they are only used for trivially relocatable types,
+// everything else gets move constructed into place and destroyed, see relocate.hpp )
 // 
 // This sstd::vector has about three times the speed of std::vector without reserve
 // And about two times the speed with reserve
+//
+// With _Inline > 0 the first _Inline elements live inside of the vector itself ( see small_vector )
+// and the heap is only touched once it grows past that
+//
+// The memory comes from _AllocT ( see allocator.hpp ), its reallocate is what the growth path uses
 
+// The inline elements of a vector, takes no space at all without any
+template<typename T, sizet _Inline>
+struct _Vector_Buffer {
+	alignas(T) unsigned char inline_memory[sizeof(T) * _Inline];
+
+	SSTD_INLINE T* Inline_Data() noexcept {
+		return reinterpret_cast<T*>(inline_memory);
+	}
+	SSTD_INLINE const T* Inline_Data() const noexcept {
+		return reinterpret_cast<const T*>(inline_memory);
+	}
+};
 template<typename T>
-class vector {
+struct _Vector_Buffer<T, 0> {
+	SSTD_INLINE T* Inline_Data() const noexcept {
+		return nullptr;
+	}
+};
+
+template<
+	typename T,
+	sizet _Inline = 0, // Elements stored inside of the vector before it allocates
+	typename _AllocT = malloc_allocator // Where the memory comes from
+>
+class vector : private _Vector_Buffer<T, _Inline>, private _AllocT {
 public:
-	using iterator = _Vector_Iterator<T>;
-	using reverse_iterator = _Vector_Reverse_Iterator<T>;
-	using const_iterator = _Vector_Const_Iterator<T>;
-	using const_reverse_iterator = _Vector_Const_Reverse_Iterator<T>;
+	using iterator = _Vector_Iterator<T, _Inline, _AllocT>;
+	using reverse_iterator = _Vector_Reverse_Iterator<T, _Inline, _AllocT>;
+	using const_iterator = _Vector_Const_Iterator<T, _Inline, _AllocT>;
+	using const_reverse_iterator = _Vector_Const_Reverse_Iterator<T, _Inline, _AllocT>;
 
 public:
 
 	// Default Constructor
-	vector() SSTD_DEFAULT;
+	vector() {
+		_Reset_Data();
+	}
+
+	// Constructor that allocates from alloc
+	SSTD_EXPLICIT vector(const _AllocT& alloc) :
+		_AllocT(alloc) {
+		_Reset_Data();
+	}
 
 	// Constructor that initialize 'length' amount of objects 
-	SSTD_EXPLICIT vector(sizet length) :
-		m_size(length), m_capacity(length), m_data((T*)malloc(sizeof(T)* length)) {
+	SSTD_EXPLICIT vector(sizet length) {
+		_Malloc_Data(length);
 		_Fill_Range(0, length);
+		m_size = length;
 	}
 
 	// Constructor that set all the object to val
-	vector(sizet length, const T& val) :
-		m_size(length), m_capacity(length), m_data((T*)malloc(sizeof(T)* length)) {
+	vector(sizet length, const T& val) {
+		_Malloc_Data(length);
 		_Fill_Range(0, length, val);
+		m_size = length;
 	}
 
 	// Constructor that initialize using a initializer list
-	vector(std::initializer_list<T> list) :
-		m_size(list.size()), m_capacity(list.size()), m_data((T*)malloc(sizeof(T)* list.size())) {
+	vector(std::initializer_list<T> list) {
+		_Malloc_Data(list.size());
 		_Fill_Range_Iter(0, list.begin(), list.end());
+		m_size = list.size();
+	}
+
+	// Copy Constructor ( the copy gets its own memory, inline or not )
+	vector(const vector& other) :
+		_Vector_Buffer<T, _Inline>(), _AllocT(other.get_allocator()) {
+		_Copy_From(other);
+	}
+
+	// Move Constructor
+	// Heap memory is just taken over, inline elements have to be relocated into the inline memory of this one
+	// ( So it only throws if the allocator or an inline element throws when moved, std::vector and co. rely on that )
+	vector(vector&& other) noexcept(std::is_nothrow_move_constructible<_AllocT>::value && _Nothrow_Relocate) :
+		_Vector_Buffer<T, _Inline>(), _AllocT(std::move(other._Alloc())) {
+		_Move_From(other);
+	}
+
+	// The memory of this one is freed first, then it takes the allocator of other along with the elements
+	vector& operator=(const vector& other) {
+		if (this != &other) {
+			clear();
+			_Alloc() = other.get_allocator();
+			_Copy_From(other);
+		}
+		return *this;
+	}
+	vector& operator=(vector&& other) noexcept(std::is_nothrow_move_assignable<_AllocT>::value && _Nothrow_Relocate) {
+		if (this != &other) {
+			clear();
+			_Alloc() = std::move(other._Alloc());
+			_Move_From(other);
+		}
+		return *this;
 	}
 
 	// Destructor
 	~vector() {
-		if (m_data) {
-			if (std::is_destructible<T>::value) {
-				for (int i = 0; i < m_size; ++i) {
-					m_data[i].~T();
-				}
-				free(m_data);
-				m_data = nullptr;
-			}
-		}
+		_Destroy_Range(m_data, m_size);
+		_Free_Data();
 	}
 
 	// Clear the vector. Aka call the destructor of every object and free the memory
+	// ( A vector with inline elements goes back to using those )
 	SSTD_INLINE void clear() noexcept {
-		if (m_size) {
-			for (int i = 0; i < m_size; ++i) {
-				m_data[i].~T();
-			}
-		}
-		if (m_data != nullptr) {
-			free(m_data);
-			m_data = nullptr;
-		}
+		_Destroy_Range(m_data, m_size);
+		_Free_Data();
+		_Reset_Data();
 		m_size = 0;
-		m_capacity = 0;
 	}
 
 	// Construct the object to the back of the vector.
@@ -116,12 +180,11 @@ public:
 
 	// Reserve a certain amount of memory ( without initialization )
 	SSTD_INLINE void reserve(sizet new_cap) {
-		m_capacity += new_cap;
 		if (m_data == nullptr) {
-			_Malloc_Data(m_capacity);
+			_Malloc_Data(m_capacity + new_cap);
 			return;
 		}
-		_Realloc_Data(m_capacity);
+		_Realloc_Data(m_capacity + new_cap);
 	}
 
 	// Resize the vector to new_size ( with initialization )
@@ -192,6 +255,11 @@ public:
 		return m_capacity;
 	}
 
+	// Whether the elements are still in the inline memory ( always false without any )
+	SSTD_INLINE bool is_inline() const noexcept {
+		return _Inline != 0 && m_data == this->Inline_Data();
+	}
+
 	SSTD_INLINE SSTD_CONSTEXPR T& front() noexcept {
 		return m_data[0];
 	}
@@ -209,6 +277,10 @@ public:
 		return m_data;
 	}
 
+	SSTD_INLINE const _AllocT& get_allocator() const noexcept {
+		return *this;
+	}
+
 	SSTD_INLINE SSTD_CONSTEXPR T& at(const sizet& key) {
 		_Check_Range(key);
 		return this->m_data[key];
@@ -274,26 +346,85 @@ private:
 	sizet m_capacity = 0;
 
 	SSTD_INLINE void _Malloc_Data(sizet memsize) {
-		m_data = (T*)malloc(sizeof(T) * memsize);
+		if (memsize <= _Inline) {
+			_Reset_Data();
+			return;
+		}
+		m_data = static_cast<T*>(_Alloc().allocate(sizeof(T) * memsize));
 		m_capacity = memsize;
 	}
 
+	// Point back at the inline memory ( or nothing )
+	SSTD_INLINE void _Reset_Data() noexcept {
+		m_data = this->Inline_Data();
+		m_capacity = _Inline;
+	}
+
+	SSTD_INLINE void _Free_Data() noexcept {
+		if (!is_inline() && m_data != nullptr) {
+			_Alloc().deallocate(m_data, sizeof(T) * m_capacity);
+		}
+		m_data = nullptr;
+	}
+
+	SSTD_INLINE _AllocT& _Alloc() noexcept {
+		return *this;
+	}
+
+	// Copy the elements of other into fresh memory ( expects nothing to be allocated yet )
+	SSTD_INLINE void _Copy_From(const vector& other) {
+		if (other.m_size == 0) {
+			_Reset_Data();
+			m_size = 0;
+			return;
+		}
+		_Malloc_Data(other.m_size);
+		_Fill_Range_Iter(0, other.m_data, other.m_data + other.m_size);
+		m_size = other.m_size;
+	}
+
+	// Take the elements of other, which is left empty ( expects nothing to be allocated yet )
+	// Moving the inline elements over is the only part of a move that touches T
+	static SSTD_CONSTEXPR bool _Nothrow_Relocate = _Inline == 0 || is_trivially_relocatable<T>::value || std::is_nothrow_move_constructible<T>::value;
+
+	SSTD_INLINE void _Move_From(vector& other) noexcept(_Nothrow_Relocate) {
+		if (other.is_inline()) {
+			_Reset_Data();
+			_Relocate_Range(m_data, other.m_data, other.m_size);
+		}
+		else {
+			m_data = other.m_data;
+			m_capacity = other.m_capacity;
+		}
+		m_size = other.m_size;
+		other._Reset_Data();
+		other.m_size = 0;
+	}
+
 	// Reallocate memory can help improve performance
 	// because instead of allocating new chunks of memory everytime,
 	// it extends the current allocated memory, 
 	// ( Allocate another chunk of memory if extension is not possible.
+	// That moves the bytes, so types that aren't trivially relocatable get relocated one by one into a new chunk instead
 	SSTD_INLINE void _Realloc_Data(sizet memsize) {
-		T* tmp = (T*)realloc(m_data, sizeof(T) * memsize);
-
-		// Handle situations if there aren't enough memory to extend
-		if (tmp == nullptr) {
-			tmp = (T*)malloc(sizeof(T) * memsize);
-			std::copy(m_data, m_data + m_capacity, tmp);
-
-			// Has already copyed the old data to the new memory, so the old memory is useless
-			free(m_data);
+		if (is_inline()) {
+			// Spill out of the inline memory
+			if (memsize <= _Inline) {
+				return;
+			}
+			T* tmp = static_cast<T*>(_Alloc().allocate(sizeof(T) * memsize));
+			_Relocate_Range(tmp, m_data, m_size);
+			m_data = tmp;
+		}
+		else if constexpr (is_trivially_relocatable<T>::value) {
+			m_data = static_cast<T*>(_Reallocate(_Alloc(), m_data, sizeof(T) * m_capacity, sizeof(T) * memsize));
+		}
+		else {
+			T* tmp = static_cast<T*>(_Alloc().allocate(sizeof(T) * memsize));
+			_Relocate_Range(tmp, m_data, m_size);
+			_Alloc().deallocate(m_data, sizeof(T) * m_capacity);
+			m_data = tmp;
 		}
-		m_data = tmp;
 		m_capacity = memsize;
 	}
 
@@ -305,14 +436,14 @@ private:
 
 	SSTD_INLINE void _Fill_Range(sizet start, sizet end, const T& val) {
 		for (; start < end; ++start) {
-			m_data[start] = val;
+			new (&m_data[start]) T(val);
 		}
 	}
 
 	template<typename _Iter>
 	SSTD_INLINE void _Fill_Range_Iter(sizet pos, _Iter _Start, _Iter _End) {
 		for (; _Start != _End; ++pos, ++_Start) {
-			m_data[pos] = *_Start;
+			new (&m_data[pos]) T(*_Start);
 		}
 	}
 
@@ -321,66 +452,34 @@ private:
 	// Then fill in the iterator
 	template<typename _Iter>
 	SSTD_INLINE void _Insert_At(sizet pos, _Iter iter_beg, _Iter iter_end) {
-		const sizet Dis = iter_end - iter_beg;
-		const sizet Total_Cap = m_size + Dis;
-		if (Total_Cap > m_capacity) {
-			// Allocate more space
-			_Realloc_Data(Total_Cap);
-		}
 		if (pos > m_size) {
 			// completly out side the 'insertable range'
 			throw std::out_of_range("Invalid insert position");
-			return;
 		}
-		if (pos < m_size) {
-			if (false && std::is_trivially_move_constructible<T>::value) {
-				std::memmove(m_data + pos + Dis, m_data + pos, sizeof(T) * (m_size - pos));
-			}
-			else {
-				for (int i = pos; i < m_size; ++i) {
-					new (m_data + Dis + i) T(std::move(m_data[i]));
-				}
-			}
+		const sizet Dis = iter_end - iter_beg;
+		const sizet Total_Cap = m_size + Dis;
+		if (m_data == nullptr) {
+			_Malloc_Data(Total_Cap);
+		}
+		else if (Total_Cap > m_capacity) {
+			// Allocate more space
+			_Realloc_Data(Total_Cap);
 		}
+		// Leaves [pos, pos + Dis) as raw memory
+		_Relocate_Range(m_data + pos + Dis, m_data + pos, m_size - pos);
 		m_size += Dis;
 		_Fill_Range_Iter(pos, iter_beg, iter_end);
 	}
 
 	SSTD_INLINE void _Erase(const sizet& ind) {
-		// Destruct if possible
-		if (std::is_destructible<T>::value) {
-			m_data[ind].~T();
-		}
-		// Just override it
-		if (std::is_trivially_move_constructible<T>::value) {
-			std::memmove(m_data + ind, m_data + ind + 1, sizeof(T) * (m_size - ind - 1));
-		}
-		else {
-			for (int i = ind; i < m_capacity; ++i) {
-				new (m_data + i) T(std::move(m_data[i + 1]));
-			}
-		}
-		--m_size;
+		_Erase_Range(ind, ind + 1);
 	}
 
 	SSTD_INLINE void _Erase_Range(const sizet& _start, const sizet& _end) {
-		// Destruct if possible
-		for (sizet i = _start; i < _end; ++i) {
-			if (std::is_destructible<T>::value) {
-				m_data[i].~T();
-			}
-		}
-		// Just override it
-		if (std::is_trivially_move_constructible<T>::value) {
-			std::memmove(m_data + _start, m_data + _end, sizeof(T) * (m_size - _end));
-		}
-		else {
-			const sizet Dis = _start - _end;
-			for (int i = _start; i < _end; ++i) {
-				new (m_data + i) T(std::move(m_data[i + Dis]));
-			}
-		}
-		m_size-=_end - _start;
+		_Destroy_Range(m_data + _start, _end - _start);
+		// Then relocate the tail over the hole
+		_Relocate_Range(m_data + _start, m_data + _end, m_size - _end);
+		m_size -= _end - _start;
 	}
 
 	SSTD_INLINE void _Check_Range(const sizet& ind) const {
@@ -397,11 +496,11 @@ private:
 //
 // -----------------------------------------
 
-template<typename T>
+template<typename T, sizet _Inline, typename _AllocT>
 class _Vector_Iterator : public random_access_iterator<T> {
-	friend class vector<T>;
+	friend class vector<T, _Inline, _AllocT>;
 public:
-	_Vector_Iterator(vector<T>* vec, sizet ind) :
+	_Vector_Iterator(vector<T, _Inline, _AllocT>* vec, sizet ind) :
 		m_vec(vec), m_ind(ind) {
 
 	}
@@ -459,7 +558,7 @@ public:
 		return this->m_vec != other.m_vec || this->m_ind != other.m_ind;
 	}
 private:
-	vector<T>* m_vec;
+	vector<T, _Inline, _AllocT>* m_vec;
 	sizet m_ind;
 };
 
@@ -469,11 +568,11 @@ private:
 //
 // -----------------------------------------
 
-template<typename T>
+template<typename T, sizet _Inline, typename _AllocT>
 class _Vector_Reverse_Iterator: public random_access_iterator<T> {
-	friend class vector<T>;
+	friend class vector<T, _Inline, _AllocT>;
 public:
-	_Vector_Reverse_Iterator(vector<T>* vec, sizet ind) :
+	_Vector_Reverse_Iterator(vector<T, _Inline, _AllocT>* vec, sizet ind) :
 		m_vec(vec), m_ind(ind) {
 
 	}
@@ -527,7 +626,7 @@ public:
 		return this->m_vec != other.m_vec || this->m_ind != other.m_ind;
 	}
 private:
-	vector<T>* m_vec;
+	vector<T, _Inline, _AllocT>* m_vec;
 	sizet m_ind;
 };
 
@@ -537,11 +636,11 @@ private:
 //
 // -----------------------------------------
 
-template<typename T>
+template<typename T, sizet _Inline, typename _AllocT>
 class _Vector_Const_Iterator: public const_random_access_iterator<T> {
-	friend class vector<T>;
+	friend class vector<T, _Inline, _AllocT>;
 public:
-	_Vector_Const_Iterator(const vector<T>* vec, sizet ind) :
+	_Vector_Const_Iterator(const vector<T, _Inline, _AllocT>* vec, sizet ind) :
 		m_vec(vec), m_ind(ind) {
 
 	}
@@ -595,7 +694,7 @@ public:
 		return this->m_vec != other.m_vec || this->m_ind != other.m_ind;
 	}
 private:
-	const vector<T>* m_vec;
+	const vector<T, _Inline, _AllocT>* m_vec;
 	sizet m_ind;
 };
 
@@ -605,11 +704,11 @@ private:
 //
 // -----------------------------------------
 
-template<typename T>
+template<typename T, sizet _Inline, typename _AllocT>
 class _Vector_Const_Reverse_Iterator : public const_random_access_iterator<T> {
-	friend class vector<T>;
+	friend class vector<T, _Inline, _AllocT>;
 public:
-	_Vector_Const_Reverse_Iterator(const vector<T>* vec, sizet ind) :
+	_Vector_Const_Reverse_Iterator(const vector<T, _Inline, _AllocT>* vec, sizet ind) :
 		m_vec(vec), m_ind(ind) {
 
 	}
@@ -663,10 +762,16 @@ public:
 		return this->m_vec != other.m_vec || this->m_ind != other.m_ind;
 	}
 private:
-	const vector<T>* m_vec;
+	const vector<T, _Inline, _AllocT>* m_vec;
 	sizet m_ind;
 };
 
+// A sstd::vector that keeps up to N elements inside of itself, and only allocates once it grows past N
+// Same API and iterators as sstd::vector
+// ( The inline elements move with the vector, so a small_vector is bigger and its elements don't have a stable address )
+template<typename T, sizet N = 8, typename _AllocT = malloc_allocator>
+using small_vector = vector<T, N, _AllocT>;
+
 SSTD_END
 
 #endif
\ No newline at end of file